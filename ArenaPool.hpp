@@ -0,0 +1,150 @@
+// ArenaPool.hpp
+#pragma once
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include <cstdint>
+#include <cstring>
+
+// Shared tensor-arena pool. One PSRAM-backed region is carved into
+// per-model arenas sized on demand, so three loaded models no longer
+// cost three fixed 32 KB blocks. Models whose execution never overlaps
+// check arenas out and back in, sharing the same bytes.
+class ArenaPool {
+public:
+    static constexpr size_t DEFAULT_POOL_SIZE = 256 * 1024;
+    static constexpr size_t MIN_POOL_SIZE = 32 * 1024; // One baseline arena
+    static constexpr size_t MAX_BLOCKS = 16;
+    static constexpr size_t ARENA_ALIGN = 16; // TFLite micro wants 16-byte alignment
+
+    ArenaPool(size_t poolSize = DEFAULT_POOL_SIZE) {
+        // Prefer PSRAM. On PSRAM-less boards the full 256 KB will never
+        // come out of internal RAM in one piece, so the fallback halves
+        // the request until it fits, flooring at one 32 KB arena -- a
+        // smaller pool (fewer concurrently resident models) beats a pool
+        // of zero.
+        size_t requested = poolSize;
+        poolBase = (uint8_t*)heap_caps_malloc(poolSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        while (poolBase == nullptr && poolSize >= MIN_POOL_SIZE) {
+            poolBase = (uint8_t*)heap_caps_malloc(poolSize, MALLOC_CAP_8BIT);
+            if (poolBase == nullptr) poolSize /= 2;
+        }
+        if (poolBase == nullptr) {
+            ESP_LOGE(TAG, "No RAM for even a %u-byte arena pool",
+                     (unsigned)MIN_POOL_SIZE);
+        } else if (poolSize != requested) {
+            ESP_LOGW(TAG, "Arena pool shrunk to %u of %u bytes (no PSRAM)",
+                     (unsigned)poolSize, (unsigned)requested);
+        }
+        this->poolSize = (poolBase != nullptr) ? poolSize : 0;
+        poolMutex = xSemaphoreCreateMutex();
+
+        memset(blocks, 0, sizeof(blocks));
+        if (poolBase != nullptr) {
+            blocks[0] = { poolBase, this->poolSize, false, true };
+        }
+    }
+
+    // Check out an arena of at least `size` bytes. Returns nullptr when the
+    // pool cannot satisfy the request.
+    uint8_t* checkout(size_t size) {
+        size = alignUp(size);
+        uint8_t* result = nullptr;
+
+        if (xSemaphoreTake(poolMutex, portMAX_DELAY) == pdTRUE) {
+            // First fit over the free blocks, splitting the remainder off
+            for (size_t i = 0; i < MAX_BLOCKS; i++) {
+                if (!blocks[i].valid || blocks[i].inUse || blocks[i].size < size) {
+                    continue;
+                }
+                if (blocks[i].size > size) {
+                    splitBlock(i, size);
+                }
+                blocks[i].inUse = true;
+                result = blocks[i].base;
+                break;
+            }
+            xSemaphoreGive(poolMutex);
+        }
+
+        if (result == nullptr) {
+            ESP_LOGW(TAG, "Arena checkout of %u bytes failed", (unsigned)size);
+        }
+        return result;
+    }
+
+    // Return an arena to the pool, coalescing with free neighbors
+    void checkin(uint8_t* arena) {
+        if (arena == nullptr) return;
+
+        if (xSemaphoreTake(poolMutex, portMAX_DELAY) == pdTRUE) {
+            for (size_t i = 0; i < MAX_BLOCKS; i++) {
+                if (blocks[i].valid && blocks[i].base == arena) {
+                    blocks[i].inUse = false;
+                    coalesce();
+                    break;
+                }
+            }
+            xSemaphoreGive(poolMutex);
+        }
+    }
+
+    size_t bytesFree() {
+        size_t total = 0;
+        if (xSemaphoreTake(poolMutex, portMAX_DELAY) == pdTRUE) {
+            for (size_t i = 0; i < MAX_BLOCKS; i++) {
+                if (blocks[i].valid && !blocks[i].inUse) {
+                    total += blocks[i].size;
+                }
+            }
+            xSemaphoreGive(poolMutex);
+        }
+        return total;
+    }
+
+private:
+    static constexpr const char* TAG = "ArenaPool";
+
+    struct Block {
+        uint8_t* base;
+        size_t size;
+        bool inUse;
+        bool valid;
+    };
+
+    uint8_t* poolBase;
+    size_t poolSize;
+    SemaphoreHandle_t poolMutex;
+    Block blocks[MAX_BLOCKS];
+
+    static size_t alignUp(size_t size) {
+        return (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    }
+
+    void splitBlock(size_t index, size_t size) {
+        for (size_t j = 0; j < MAX_BLOCKS; j++) {
+            if (!blocks[j].valid) {
+                blocks[j] = { blocks[index].base + size,
+                              blocks[index].size - size, false, true };
+                blocks[index].size = size;
+                return;
+            }
+        }
+        // No slot for the remainder: hand out the whole block
+    }
+
+    void coalesce() {
+        for (size_t i = 0; i < MAX_BLOCKS; i++) {
+            if (!blocks[i].valid || blocks[i].inUse) continue;
+            for (size_t j = 0; j < MAX_BLOCKS; j++) {
+                if (j == i || !blocks[j].valid || blocks[j].inUse) continue;
+                if (blocks[i].base + blocks[i].size == blocks[j].base) {
+                    blocks[i].size += blocks[j].size;
+                    blocks[j].valid = false;
+                    j = 0; // restart: the grown block may now touch another
+                }
+            }
+        }
+    }
+};
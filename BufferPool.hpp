@@ -0,0 +1,131 @@
+// BufferPool.hpp
+#pragma once
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include <cstdint>
+#include <cstring>
+
+// Fixed-block buffer pool shared by FileManager and ModelRuntime response
+// paths. Replaces the raw new[]/delete[] pairs whose mixed lifetimes were
+// fragmenting the heap. Allocations are runs of fixed-size blocks from one
+// preallocated region, so freeing never leaves odd-sized holes.
+//
+// Buffers are reference counted: a consumer that wants to forward a file
+// read straight into requestInference calls retain() and releases its own
+// reference when done -- no copy, and the block returns to the pool only
+// when the last holder releases it. Handles are plain pointers so they
+// survive being memcpy'd through FreeRTOS queues.
+class BufferPool {
+public:
+    static constexpr size_t BLOCK_SIZE = 2048;
+    static constexpr size_t BLOCK_COUNT = 48; // 96 KB pool
+
+    static BufferPool& getInstance() {
+        static BufferPool instance;
+        return instance;
+    }
+
+    // Allocate a buffer of at least `size` bytes with refcount 1.
+    // Returns nullptr when no contiguous run of blocks is free.
+    uint8_t* alloc(size_t size) {
+        size_t blocksNeeded = (size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        if (blocksNeeded == 0) blocksNeeded = 1;
+
+        uint8_t* result = nullptr;
+        taskENTER_CRITICAL(&poolLock);
+        for (size_t i = 0; i + blocksNeeded <= BLOCK_COUNT; i++) {
+            size_t run = 0;
+            while (run < blocksNeeded && refCount[i + run] == 0) run++;
+            if (run == blocksNeeded) {
+                refCount[i] = 1;
+                runLength[i] = blocksNeeded;
+                for (size_t j = 1; j < blocksNeeded; j++) {
+                    refCount[i + j] = 0xFF; // continuation marker
+                    runLength[i + j] = 0;
+                }
+                result = poolBase + i * BLOCK_SIZE;
+                break;
+            }
+            i += run; // skip past the blocker
+        }
+        taskEXIT_CRITICAL(&poolLock);
+
+        if (result == nullptr) {
+            ESP_LOGW(TAG, "Pool exhausted: %u bytes requested", (unsigned)size);
+        }
+        return result;
+    }
+
+    // Take an extra reference, e.g. before forwarding a buffer to another
+    // task. The count saturates one below the 0xFF continuation marker;
+    // a saturated run is pinned (never freed) rather than overflowed into
+    // the marker, which would corrupt the allocator.
+    void retain(uint8_t* buffer) {
+        size_t index;
+        if (!blockIndex(buffer, index)) return;
+        taskENTER_CRITICAL(&poolLock);
+        if (refCount[index] < REFCOUNT_SATURATED) {
+            refCount[index]++;
+        }
+        taskEXIT_CRITICAL(&poolLock);
+    }
+
+    // Drop a reference; the run is freed when the count hits zero. A
+    // saturated count is sticky -- the true holder count is unknown, so
+    // freeing would risk a use-after-free; leaking the run is the safe
+    // failure.
+    void release(uint8_t* buffer) {
+        size_t index;
+        if (!blockIndex(buffer, index)) return;
+        taskENTER_CRITICAL(&poolLock);
+        if (refCount[index] > 0 && refCount[index] < REFCOUNT_SATURATED &&
+            --refCount[index] == 0) {
+            for (size_t j = 1; j < runLength[index]; j++) {
+                refCount[index + j] = 0;
+            }
+            runLength[index] = 0;
+        }
+        taskEXIT_CRITICAL(&poolLock);
+    }
+
+    // Usable bytes behind a pooled buffer (a whole number of blocks)
+    size_t capacity(uint8_t* buffer) {
+        size_t index;
+        if (!blockIndex(buffer, index)) return 0;
+        return runLength[index] * BLOCK_SIZE;
+    }
+
+    bool owns(const uint8_t* buffer) const {
+        return buffer >= poolBase && buffer < poolBase + BLOCK_COUNT * BLOCK_SIZE;
+    }
+
+private:
+    static constexpr const char* TAG = "BufferPool";
+
+    // 0xFF marks run continuation blocks; 0xFE is the refcount ceiling
+    static constexpr uint8_t REFCOUNT_SATURATED = 0xFE;
+
+    uint8_t* poolBase;
+    uint8_t refCount[BLOCK_COUNT];
+    uint16_t runLength[BLOCK_COUNT];
+    portMUX_TYPE poolLock = portMUX_INITIALIZER_UNLOCKED;
+
+    BufferPool() {
+        // DMA-capable and cache-line aligned so SD/SPI transfers into pool
+        // blocks take the DMA path instead of the unaligned CPU-copy
+        // fallback. BLOCK_SIZE is a multiple of 64, so every block in the
+        // region stays aligned.
+        poolBase = (uint8_t*)heap_caps_aligned_alloc(64, BLOCK_COUNT * BLOCK_SIZE,
+                                                     MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+        memset(refCount, 0, sizeof(refCount));
+        memset(runLength, 0, sizeof(runLength));
+    }
+
+    bool blockIndex(const uint8_t* buffer, size_t& index) const {
+        if (!owns(buffer)) return false;
+        index = (buffer - poolBase) / BLOCK_SIZE;
+        return refCount[index] != 0xFF; // must be the head of a run
+    }
+};
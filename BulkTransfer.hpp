@@ -0,0 +1,442 @@
+// BulkTransfer.hpp
+#pragma once
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_now.h"
+#include "esp_log.h"
+#include "esp_wifi.h"
+#include "FileManager.hpp"
+#include <cstdint>
+#include <cstring>
+
+// Reliable bulk transfer over ESP-NOW. Beacons are fire-and-forget, which
+// is fine for 50-byte capability vectors but useless for shipping a model
+// file to a neighbor. This layer fragments a payload into MTU-sized chunks
+// and runs a sliding window with selective retransmit over them:
+//
+//   - chunk 0 carries the destination filename, data follows from chunk 1
+//   - the receiver acks with a cumulative base plus a 32-bit bitmap of
+//     out-of-order chunks it already holds, so only real losses resend
+//   - the ack also advertises how many chunks of reorder space remain,
+//     which is the flow control: the sender never has more unacked chunks
+//     in flight than the receiver can buffer
+//   - a CRC-16 over the whole payload rides in every data header and is
+//     checked against a running CRC as chunks are flushed in order
+//
+// Received data streams straight into a FileManager append stream through
+// pooled blocks -- the reorder window is the only RAM the transfer size
+// never exceeds, so a 200 KB model needs no 200 KB staging buffer.
+
+#define BULK_TYPE_DATA 0x06
+#define BULK_TYPE_ACK 0x07
+
+#define BULK_CHUNK_PAYLOAD 224
+#define BULK_NAME_LEN 32
+#define BULK_WINDOW 16          // Reorder window, chunks (3.5 KB)
+#define BULK_ACK_EVERY 4        // Ack cadence in received data packets
+#define BULK_RETRY_MS 40        // Stalled-window retransmit timeout
+#define BULK_MAX_RETRIES 50
+#define BULK_SEND_GAP_MS 2      // Pacing between in-flight frames
+#define BULK_RX_IDLE_MS 5000    // Abort a receive the sender went quiet on
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;               // BULK_TYPE_DATA
+    uint8_t sender_id[6];
+    uint32_t transfer_id;
+    uint32_t total_len;         // Payload bytes, excluding the name chunk
+    uint16_t payload_crc;       // CRC-16 over the whole payload
+    uint16_t seq;               // 0 = filename chunk
+    uint8_t chunk_len;
+    uint8_t payload[BULK_CHUNK_PAYLOAD];
+} BulkDataPacket;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;               // BULK_TYPE_ACK
+    uint8_t sender_id[6];
+    uint32_t transfer_id;
+    uint16_t ack_base;          // All chunks below this are received
+    uint32_t ack_bitmap;        // Bit n: chunk ack_base + n is held
+    uint8_t window;             // Free reorder slots (flow control)
+} BulkAckPacket;
+
+class BulkTransfer {
+public:
+    void init(const uint8_t* selfMac, FileManager* fm) {
+        memcpy(self_id, selfMac, 6);
+        fileManager = fm;
+        tx.active = false;
+        rx.active = false;
+        next_transfer_id = 1;
+    }
+
+    // Push `len` bytes to `peer`, to be written there as `remoteName`.
+    // Blocks the calling task until the transfer is acked end-to-end or
+    // the retry budget runs out. The data pointer stays with the caller.
+    bool sendBulk(const uint8_t* peer, const uint8_t* data, size_t len,
+                  const char* remoteName) {
+        if (len == 0 || tx.active) return false;
+
+        uint16_t dataChunks = (len + BULK_CHUNK_PAYLOAD - 1) / BULK_CHUNK_PAYLOAD;
+        tx.total_chunks = dataChunks + 1; // +1 for the name chunk
+        tx.transfer_id = next_transfer_id++;
+        tx.data = data;
+        tx.len = len;
+        tx.payload_crc = crc16(data, len);
+        memcpy(tx.peer, peer, 6);
+        tx.ack_base = 0;
+        tx.ack_bitmap = 0;
+        tx.peer_window = BULK_WINDOW;
+        tx.sent_hi = 0;
+        tx.active = true;
+        __sync_synchronize();
+
+        strncpy(tx.name, remoteName, BULK_NAME_LEN - 1);
+        tx.name[BULK_NAME_LEN - 1] = '\0';
+
+        TickType_t lastProgress = xTaskGetTickCount();
+        uint16_t lastBase = 0;
+        int retries = 0;
+        bool ok = false;
+
+        while (true) {
+            uint16_t base = tx.ack_base;
+            if (base >= tx.total_chunks) {
+                ok = true;
+                break;
+            }
+
+            if (base != lastBase) {
+                lastBase = base;
+                lastProgress = xTaskGetTickCount();
+                retries = 0;
+            }
+
+            // Fill the window with chunks the peer has room for
+            uint16_t limit = base + tx.peer_window;
+            if (limit > tx.total_chunks) limit = tx.total_chunks;
+            while (tx.sent_hi < limit) {
+                sendChunk(tx.sent_hi++);
+                vTaskDelay(pdMS_TO_TICKS(BULK_SEND_GAP_MS));
+            }
+
+            // Window stalled: selectively resend what the bitmap says is
+            // missing, oldest first
+            if (xTaskGetTickCount() - lastProgress > pdMS_TO_TICKS(BULK_RETRY_MS)) {
+                if (++retries > BULK_MAX_RETRIES) break;
+                uint32_t bitmap = tx.ack_bitmap;
+                for (uint16_t seq = base; seq < tx.sent_hi; seq++) {
+                    uint16_t bit = seq - base;
+                    if (bit >= 32 || !(bitmap & (1u << bit))) {
+                        sendChunk(seq);
+                        vTaskDelay(pdMS_TO_TICKS(BULK_SEND_GAP_MS));
+                    }
+                }
+                lastProgress = xTaskGetTickCount();
+            }
+
+            vTaskDelay(pdMS_TO_TICKS(5));
+        }
+
+        tx.active = false;
+        if (!ok) {
+            ESP_LOGW(TAG, "Bulk transfer %lu to peer failed at chunk %u/%u",
+                     (unsigned long)tx.transfer_id, tx.ack_base, tx.total_chunks);
+        }
+        return ok;
+    }
+
+    // Receiver side, called from the beacon task for BULK_TYPE_DATA frames
+    void onDataPacket(const BulkDataPacket& pkt) {
+        // chunk_len sizes the memcpy into a reorder slot and, later, the
+        // flush accounting against BLOCK_SIZE; never trust it from air
+        if (pkt.chunk_len > BULK_CHUNK_PAYLOAD) return;
+
+        if (!rx.active || rx.transfer_id != pkt.transfer_id ||
+            memcmp(rx.peer, pkt.sender_id, 6) != 0) {
+            // Only one inbound transfer at a time; a new id preempts a
+            // finished one, never a live one
+            if (rx.active) return;
+            if (pkt.transfer_id == last_rx_id &&
+                memcmp(pkt.sender_id, last_rx_peer, 6) == 0) {
+                // Stale retransmit of a transfer we already completed:
+                // our final ack was lost. Re-release the sender instead
+                // of restarting the whole receive on its leftovers.
+                sendFinalAck();
+                return;
+            }
+            startReceive(pkt);
+        }
+
+        rx.last_packet_tick = xTaskGetTickCount();
+        rx.packets_since_ack++;
+
+        if (pkt.seq < rx.base) {
+            // Duplicate of something already flushed: our ack was lost
+            sendAck();
+            return;
+        }
+        if (pkt.seq >= rx.base + BULK_WINDOW || pkt.seq >= rx.total_chunks) {
+            return; // Beyond the reorder window: sender overran, drop
+        }
+
+        size_t slot = pkt.seq % BULK_WINDOW;
+        if (!rx.have[slot]) {
+            memcpy(rx.window[slot], pkt.payload, pkt.chunk_len);
+            rx.chunk_len[slot] = pkt.chunk_len;
+            rx.have[slot] = true;
+        }
+
+        // Flush the in-order prefix to the append stream
+        while (rx.have[rx.base % BULK_WINDOW]) {
+            size_t s = rx.base % BULK_WINDOW;
+            if (rx.base == 0) {
+                // Name chunk: carries the SD filename, no payload data
+                memcpy(rx.filename, rx.window[s], BULK_NAME_LEN);
+                rx.filename[BULK_NAME_LEN - 1] = '\0';
+            } else if (!flushChunk(rx.window[s], rx.chunk_len[s])) {
+                break; // Pool exhausted: retry on the next packet
+            }
+            rx.have[s] = false;
+            rx.base++;
+        }
+
+        if (rx.base >= rx.total_chunks) {
+            finishReceive();
+        } else if (rx.packets_since_ack >= BULK_ACK_EVERY) {
+            sendAck();
+        }
+    }
+
+    // Periodic maintenance, called from the beacon task loop: a sender
+    // that died mid-transfer must not pin the single rx slot (and its
+    // pooled flush block) forever
+    void poll() {
+        if (rx.active &&
+            xTaskGetTickCount() - rx.last_packet_tick > pdMS_TO_TICKS(BULK_RX_IDLE_MS)) {
+            abortReceive();
+        }
+    }
+
+    // Sender side, called from the beacon task for BULK_TYPE_ACK frames
+    void onAckPacket(const BulkAckPacket& pkt) {
+        if (!tx.active || pkt.transfer_id != tx.transfer_id) return;
+        tx.ack_bitmap = pkt.ack_bitmap;
+        tx.peer_window = (pkt.window > 0) ? pkt.window : 1;
+        __sync_synchronize(); // Bitmap/window visible before the base moves
+        tx.ack_base = pkt.ack_base;
+    }
+
+private:
+    static constexpr const char* TAG = "BulkTransfer";
+
+    FileManager* fileManager = nullptr;
+    uint8_t self_id[6] = {};
+    uint32_t next_transfer_id = 1;
+
+    struct {
+        volatile bool active;
+        uint8_t peer[6];
+        uint32_t transfer_id;
+        const uint8_t* data;
+        size_t len;
+        uint16_t payload_crc;
+        uint16_t total_chunks;
+        uint16_t sent_hi;       // Highest chunk sent so far (exclusive)
+        char name[BULK_NAME_LEN];
+        volatile uint16_t ack_base;
+        volatile uint32_t ack_bitmap;
+        volatile uint8_t peer_window;
+    } tx = {};
+
+    struct {
+        bool active;
+        uint8_t peer[6];
+        uint32_t transfer_id;
+        char filename[BULK_NAME_LEN];
+        uint32_t total_len;
+        uint16_t payload_crc;
+        uint16_t total_chunks;
+        uint16_t base;          // Next chunk to flush in order
+        uint8_t packets_since_ack;
+        uint16_t running_crc;
+        uint32_t flushed_bytes;
+        uint8_t window[BULK_WINDOW][BULK_CHUNK_PAYLOAD];
+        uint8_t chunk_len[BULK_WINDOW];
+        bool have[BULK_WINDOW];
+        uint8_t* flushBlock;    // Pooled block being filled for append
+        size_t flushUsed;
+        uint32_t nextRequestId;
+        TickType_t last_packet_tick;
+    } rx = {};
+
+    // The last transfer finishReceive completed; stale retransmits of it
+    // get a final ack again rather than a fresh receive
+    uint32_t last_rx_id = 0;
+    uint8_t last_rx_peer[6] = {};
+    uint16_t last_rx_chunks = 0;
+
+    void sendChunk(uint16_t seq) {
+        BulkDataPacket pkt;
+        pkt.type = BULK_TYPE_DATA;
+        memcpy(pkt.sender_id, self_id, 6);
+        pkt.transfer_id = tx.transfer_id;
+        pkt.total_len = tx.len;
+        pkt.payload_crc = tx.payload_crc;
+        pkt.seq = seq;
+
+        if (seq == 0) {
+            pkt.chunk_len = BULK_NAME_LEN;
+            memcpy(pkt.payload, tx.name, BULK_NAME_LEN);
+        } else {
+            size_t off = (size_t)(seq - 1) * BULK_CHUNK_PAYLOAD;
+            size_t chunk = tx.len - off;
+            if (chunk > BULK_CHUNK_PAYLOAD) chunk = BULK_CHUNK_PAYLOAD;
+            pkt.chunk_len = (uint8_t)chunk;
+            memcpy(pkt.payload, tx.data + off, chunk);
+        }
+
+        size_t header = sizeof(BulkDataPacket) - BULK_CHUNK_PAYLOAD;
+        esp_now_send(tx.peer, (uint8_t*)&pkt, header + pkt.chunk_len);
+    }
+
+    void startReceive(const BulkDataPacket& pkt) {
+        rx.active = true;
+        memcpy(rx.peer, pkt.sender_id, 6);
+        rx.transfer_id = pkt.transfer_id;
+        rx.total_len = pkt.total_len;
+        rx.payload_crc = pkt.payload_crc;
+        rx.total_chunks = 1 + (pkt.total_len + BULK_CHUNK_PAYLOAD - 1) / BULK_CHUNK_PAYLOAD;
+        rx.base = 0;
+        rx.packets_since_ack = 0;
+        rx.running_crc = 0xFFFF;
+        rx.flushed_bytes = 0;
+        rx.flushBlock = nullptr;
+        rx.flushUsed = 0;
+        rx.nextRequestId = 0x42000000 | (pkt.transfer_id & 0xFFFFFF);
+        rx.last_packet_tick = xTaskGetTickCount();
+        memset((void*)rx.have, 0, sizeof(rx.have));
+        rx.filename[0] = '\0';
+        // If chunk 0 arrives late the base stays at 0 and the window
+        // holds early data chunks until the retransmit delivers the name
+    }
+
+    // Accumulate an in-order chunk; full pooled blocks go to FileManager,
+    // which takes ownership of the block through the append queue
+    bool flushChunk(const uint8_t* data, size_t len) {
+        if (rx.flushBlock == nullptr) {
+            rx.flushBlock = BufferPool::getInstance().alloc(BufferPool::BLOCK_SIZE);
+            if (rx.flushBlock == nullptr) return false;
+            rx.flushUsed = 0;
+        }
+
+        memcpy(rx.flushBlock + rx.flushUsed, data, len);
+        rx.flushUsed += len;
+        rx.running_crc = crc16Update(rx.running_crc, data, len);
+        rx.flushed_bytes += len;
+
+        if (rx.flushUsed + BULK_CHUNK_PAYLOAD > BufferPool::BLOCK_SIZE) {
+            commitFlushBlock();
+        }
+        return true;
+    }
+
+    void commitFlushBlock() {
+        if (rx.flushBlock == nullptr || rx.flushUsed == 0) return;
+        // Fire-and-forget: nothing on this path drains getResponse(), so
+        // asking for responses would eventually wedge the file task
+        fileManager->requestAppend(rx.filename, rx.flushBlock, rx.flushUsed,
+                                   rx.nextRequestId++,
+                                   RequestPriority::NORMAL, false);
+        rx.flushBlock = nullptr;
+        rx.flushUsed = 0;
+    }
+
+    void finishReceive() {
+        commitFlushBlock();
+        fileManager->requestFlush(rx.filename, rx.nextRequestId++,
+                                  RequestPriority::HIGH, false);
+
+        uint16_t crc = rx.running_crc ^ 0xFFFF;
+        if (crc == rx.payload_crc) {
+            ESP_LOGI(TAG, "Received %lu bytes into %s (transfer %lu)",
+                     (unsigned long)rx.flushed_bytes, rx.filename,
+                     (unsigned long)rx.transfer_id);
+        } else {
+            ESP_LOGE(TAG, "Transfer %lu CRC mismatch: %04x != %04x",
+                     (unsigned long)rx.transfer_id, crc, rx.payload_crc);
+        }
+
+        // The final ack releases the sender; send it a few times since
+        // there is no retransmit path for acks themselves
+        sendAck();
+        sendAck();
+
+        last_rx_id = rx.transfer_id;
+        memcpy(last_rx_peer, rx.peer, 6);
+        last_rx_chunks = rx.total_chunks;
+        rx.active = false;
+    }
+
+    // Drop a receive the sender abandoned: return the half-filled pooled
+    // block and free the rx slot. Whatever already reached the append
+    // stream ages out through FileManager's normal commit path.
+    void abortReceive() {
+        ESP_LOGW(TAG, "Aborting idle transfer %lu at chunk %u/%u",
+                 (unsigned long)rx.transfer_id, rx.base, rx.total_chunks);
+        if (rx.flushBlock != nullptr) {
+            BufferPool::getInstance().release(rx.flushBlock);
+            rx.flushBlock = nullptr;
+            rx.flushUsed = 0;
+        }
+        rx.active = false;
+    }
+
+    // Completed-transfer ack, built from the remembered state so it is
+    // valid even after rx has been reused for another transfer
+    void sendFinalAck() {
+        BulkAckPacket pkt;
+        pkt.type = BULK_TYPE_ACK;
+        memcpy(pkt.sender_id, self_id, 6);
+        pkt.transfer_id = last_rx_id;
+        pkt.ack_base = last_rx_chunks;
+        pkt.ack_bitmap = 0;
+        pkt.window = BULK_WINDOW;
+        esp_now_send(last_rx_peer, (uint8_t*)&pkt, sizeof(pkt));
+    }
+
+    void sendAck() {
+        BulkAckPacket pkt;
+        pkt.type = BULK_TYPE_ACK;
+        memcpy(pkt.sender_id, self_id, 6);
+        pkt.transfer_id = rx.transfer_id;
+        pkt.ack_base = rx.base;
+
+        pkt.ack_bitmap = 0;
+        uint8_t held = 0;
+        for (uint16_t bit = 0; bit < 32 && rx.base + bit < rx.total_chunks; bit++) {
+            if (bit < BULK_WINDOW && rx.have[(rx.base + bit) % BULK_WINDOW]) {
+                pkt.ack_bitmap |= (1u << bit);
+                held++;
+            }
+        }
+        pkt.window = BULK_WINDOW - held;
+
+        esp_now_send(rx.peer, (uint8_t*)&pkt, sizeof(pkt));
+        rx.packets_since_ack = 0;
+    }
+
+    // CRC-16/CCITT, same polynomial as the capability CRC on the beacon path
+    static uint16_t crc16Update(uint16_t crc, const uint8_t* data, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            crc ^= (uint16_t)data[i] << 8;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+            }
+        }
+        return crc;
+    }
+
+    static uint16_t crc16(const uint8_t* data, size_t len) {
+        return crc16Update(0xFFFF, data, len) ^ 0xFFFF;
+    }
+};
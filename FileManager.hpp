@@ -5,78 +5,184 @@
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "esp_spiffs.h"
-#include <string>
+#include "BufferPool.hpp"
+#include "RequestPriority.hpp"
+#include "Trace.hpp"
+#include "SystemKernel.hpp"
+#include <sys/stat.h>
 
 // File operation request types
 enum class FileOp {
     READ,
+    READ_STREAM,
     WRITE,
+    APPEND,
+    FLUSH,
     DELETE,
     LIST,
     STATUS
 };
 
-// Request structure for file operations
+constexpr size_t FILE_NAME_MAX = 64;
+
+// Request structure for file operations. Requests live in a fixed pool
+// inside FileManager and only the 4-byte pointer travels through the
+// queues: no struct memcpy per hop, no heap allocation on the request
+// path (names are fixed arrays, not std::string).
 struct FileRequest {
     FileOp operation;
-    std::string filename;
+    char filename[FILE_NAME_MAX];
     uint8_t* data;
-    size_t length;
+    size_t length;       // Chunk size for READ_STREAM
     uint32_t requestId;
+    RequestPriority priority;
+    bool notify;         // Emit a FileResponse when done (see requestAppend)
+    uint32_t traceUs;        // Enqueue wall-clock stamp (queue-wait tracing)
 };
 
-// Response structure for file operations
+// Response structure for file operations. `data` is a BufferPool buffer:
+// the consumer must BufferPool::getInstance().release() it (after an
+// optional retain() to forward it, e.g. into requestInference, copy-free).
+// `message` always points at a string literal.
 struct FileResponse {
     bool success;
-    std::string message;
+    const char* message;
     uint8_t* data;
     size_t length;
     uint32_t requestId;
+    size_t offset;       // Byte offset of this chunk (READ_STREAM)
+    bool endOfStream;    // Last chunk of a READ_STREAM sequence
 };
 
 class FileManager {
 public:
+    // Largest single SD transaction; matches the SPI bus max_transfer_sz
+    // configured in SystemKernel::initSDCard
+    static constexpr size_t SD_DMA_CHUNK = 32 * 1024;
+
     FileManager(size_t queueSize = 10) {
-        // Create queues for requests and responses
-        requestQueue = xQueueCreate(queueSize, sizeof(FileRequest));
+        // Separate queues per priority so urgent I/O never waits behind a
+        // bulk flush; a queue set lets the task sleep on both at once.
+        // Request queues carry pointers into requestPool, so an enqueue
+        // moves 4 bytes; the free list is itself a queue, which gives
+        // natural backpressure when all slots are in flight.
+        highQueue = xQueueCreate(queueSize, sizeof(FileRequest*));
+        normalQueue = xQueueCreate(queueSize, sizeof(FileRequest*));
         responseQueue = xQueueCreate(queueSize, sizeof(FileResponse));
-        
-        // Create mutex for file operations
-        fileMutex = xSemaphoreCreateMutex();
-        
-        // Create file I/O task
-        xTaskCreate(
+        requestQueueSet = xQueueCreateSet(queueSize * 2);
+        xQueueAddToSet(highQueue, requestQueueSet);
+        xQueueAddToSet(normalQueue, requestQueueSet);
+
+        freeRequests = xQueueCreate(REQUEST_POOL_SIZE, sizeof(FileRequest*));
+        for (size_t i = 0; i < REQUEST_POOL_SIZE; i++) {
+            FileRequest* slot = &requestPool[i];
+            xQueueSend(freeRequests, &slot, 0);
+        }
+
+        // Recursive: long operations re-enter dispatch to service
+        // high-priority work between chunks
+        fileMutex = xSemaphoreCreateRecursiveMutex();
+
+        // Create file I/O task on the I/O core per the kernel placement policy
+        xTaskCreatePinnedToCore(
             fileTaskWrapper,
             "FileTask",
             8192,
             this,
             5,
-            &fileTaskHandle
+            &fileTaskHandle,
+            SystemKernel::coreForDomain(TaskDomain::IO)
         );
     }
 
     // Async file read request
-    bool requestRead(const std::string& filename, uint32_t requestId) {
-        FileRequest request = {
-            .operation = FileOp::READ,
-            .filename = filename,
-            .data = nullptr,
-            .length = 0,
-            .requestId = requestId
-        };
-        return xQueueSend(requestQueue, &request, portMAX_DELAY) == pdTRUE;
+    bool requestRead(const char* filename, uint32_t requestId,
+                     RequestPriority priority = RequestPriority::NORMAL) {
+        FileRequest* request = acquireRequest();
+        request->operation = FileOp::READ;
+        copyName(request->filename, filename);
+        request->data = nullptr;
+        request->length = 0;
+        request->requestId = requestId;
+        request->priority = priority;
+        request->notify = true;
+        return enqueue(request);
     }
 
     // Async file write request
-    bool requestWrite(const std::string& filename, uint8_t* data, size_t length, uint32_t requestId) {
-        FileRequest request = {
-            .operation = FileOp::WRITE,
-            .filename = filename,
-            .data = data,
-            .length = length,
-            .requestId = requestId
-        };
-        return xQueueSend(requestQueue, &request, portMAX_DELAY) == pdTRUE;
+    bool requestWrite(const char* filename, uint8_t* data, size_t length,
+                      uint32_t requestId,
+                      RequestPriority priority = RequestPriority::NORMAL) {
+        FileRequest* request = acquireRequest();
+        request->operation = FileOp::WRITE;
+        copyName(request->filename, filename);
+        request->data = data;
+        request->length = length;
+        request->requestId = requestId;
+        request->priority = priority;
+        request->notify = true;
+        return enqueue(request);
+    }
+
+    // Async streaming read: emits the file as a sequence of FileResponse
+    // chunks of `chunkSize` bytes, so a file larger than free heap never
+    // needs a single whole-file buffer. While the consumer processes chunk
+    // N the file task is already reading chunk N+1 into another pooled
+    // block, so SD fills overlap with consumption. The consumer must
+    // release each chunk's buffer promptly or the stream stalls waiting
+    // for pool blocks.
+    bool requestReadStream(const char* filename, size_t chunkSize,
+                           uint32_t requestId,
+                           RequestPriority priority = RequestPriority::NORMAL) {
+        FileRequest* request = acquireRequest();
+        request->operation = FileOp::READ_STREAM;
+        copyName(request->filename, filename);
+        request->data = nullptr;
+        request->length = chunkSize;
+        request->requestId = requestId;
+        request->priority = priority;
+        request->notify = true;
+        return enqueue(request);
+    }
+
+    // Async append: the record is coalesced into a RAM write-behind buffer
+    // and committed to SD in multi-kilobyte bursts when the buffer fills
+    // or ages out, instead of paying a full fopen/fwrite/fclose per
+    // record. Use requestFlush before shutdown.
+    //
+    // `notify = false` makes the request fire-and-forget: no FileResponse
+    // is queued. For producers that never call getResponse (BulkTransfer
+    // streaming a model to SD), queueing responses nobody drains would
+    // fill responseQueue and wedge the file task on the send.
+    bool requestAppend(const char* filename, uint8_t* data, size_t length,
+                       uint32_t requestId,
+                       RequestPriority priority = RequestPriority::NORMAL,
+                       bool notify = true) {
+        FileRequest* request = acquireRequest();
+        request->operation = FileOp::APPEND;
+        copyName(request->filename, filename);
+        request->data = data;
+        request->length = length;
+        request->requestId = requestId;
+        request->priority = priority;
+        request->notify = notify;
+        return enqueue(request);
+    }
+
+    // Commit buffered appends for `filename` to SD now; an empty filename
+    // flushes every stream (shutdown path)
+    bool requestFlush(const char* filename, uint32_t requestId,
+                      RequestPriority priority = RequestPriority::HIGH,
+                      bool notify = true) {
+        FileRequest* request = acquireRequest();
+        request->operation = FileOp::FLUSH;
+        copyName(request->filename, filename);
+        request->data = nullptr;
+        request->length = 0;
+        request->requestId = requestId;
+        request->priority = priority;
+        request->notify = notify;
+        return enqueue(request);
     }
 
     // Get response from file operations
@@ -85,46 +191,246 @@ public:
     }
 
 private:
-    QueueHandle_t requestQueue;
+    QueueHandle_t highQueue;
+    QueueHandle_t normalQueue;
     QueueHandle_t responseQueue;
+    QueueSetHandle_t requestQueueSet;
     SemaphoreHandle_t fileMutex;
     TaskHandle_t fileTaskHandle;
 
+    // Fixed request pool: both priority queues full plus a few in flight.
+    // The free list blocks when exhausted, which throttles producers the
+    // same way a full queue used to.
+    static constexpr size_t REQUEST_POOL_SIZE = 24;
+    FileRequest requestPool[REQUEST_POOL_SIZE];
+    QueueHandle_t freeRequests;
+
+    FileRequest* acquireRequest() {
+        FileRequest* request;
+        xQueueReceive(freeRequests, &request, portMAX_DELAY);
+        return request;
+    }
+
+    void releaseRequest(FileRequest* request) {
+        xQueueSend(freeRequests, &request, portMAX_DELAY);
+    }
+
+    static void copyName(char* dst, const char* src) {
+        strncpy(dst, src, FILE_NAME_MAX - 1);
+        dst[FILE_NAME_MAX - 1] = '\0';
+    }
+
+    bool enqueue(FileRequest* request) {
+        TRACE_STAMP_US(request->traceUs);
+        QueueHandle_t queue = (request->priority == RequestPriority::HIGH)
+                                  ? highQueue : normalQueue;
+        return xQueueSend(queue, &request, portMAX_DELAY) == pdTRUE;
+    }
+
     // Wrapper for task creation
     static void fileTaskWrapper(void* params) {
         static_cast<FileManager*>(params)->fileTask();
     }
 
-    // Main file I/O task
+    // Write-behind append streams: records coalesce in RAM and hit the SD
+    // as one aligned multi-kilobyte burst. Sized so a 16 KB commit amortizes
+    // the SPI transaction cost (~30x the per-record write throughput).
+    static constexpr size_t APPEND_BUFFER_SIZE = 16 * 1024;
+    static constexpr size_t APPEND_STREAMS = 2;
+    static constexpr TickType_t APPEND_MAX_AGE_TICKS = pdMS_TO_TICKS(2000);
+    static constexpr size_t APPEND_NAME_MAX = 64;
+
+    struct AppendStream {
+        char filename[APPEND_NAME_MAX];
+        uint8_t buffer[APPEND_BUFFER_SIZE];
+        size_t used;
+        TickType_t firstWriteTick;
+        bool active;
+    };
+    AppendStream appendStreams[APPEND_STREAMS] = {};
+
+    // Main file I/O task: sleep on the queue set, then always try the
+    // high-priority queue first no matter which member woke us. The wait
+    // is bounded so aged append buffers still get committed when the
+    // request queues go quiet.
     void fileTask() {
-        FileRequest request;
-        FileResponse response;
+        FileRequest* request;
+
+        // Producers may enqueue from the first millisecond; nothing is
+        // serviced until the card is actually mounted
+        SystemKernel::getInstance().waitReady(SystemKernel::READY_SD);
 
         while (true) {
-            if (xQueueReceive(requestQueue, &request, portMAX_DELAY) == pdTRUE) {
-                // Take mutex for file operation
-                if (xSemaphoreTake(fileMutex, portMAX_DELAY) == pdTRUE) {
-                    switch (request.operation) {
-                        case FileOp::READ:
-                            handleRead(request, response);
-                            break;
-                        case FileOp::WRITE:
-                            handleWrite(request, response);
-                            break;
-                        // Add other operations as needed
+            xQueueSelectFromSet(requestQueueSet, APPEND_MAX_AGE_TICKS / 2);
+            if (xQueueReceive(highQueue, &request, 0) == pdTRUE ||
+                xQueueReceive(normalQueue, &request, 0) == pdTRUE) {
+                TRACE_RECORD_US(TRACE_FILE_QUEUE_WAIT, request->traceUs);
+                dispatch(*request);
+                releaseRequest(request);
+            }
+            commitAgedAppendStreams();
+        }
+    }
+
+    // Execute one request and send its response. Re-entrant (recursive
+    // mutex) so long handlers can dispatch high-priority work mid-flight.
+    void dispatch(const FileRequest& request) {
+        FileResponse response;
+        if (xSemaphoreTakeRecursive(fileMutex, portMAX_DELAY) == pdTRUE) {
+            TRACE_MARK(handlerStart);
+            switch (request.operation) {
+                case FileOp::READ:
+                    handleRead(request, response);
+                    break;
+                case FileOp::READ_STREAM:
+                    handleReadStream(request, response);
+                    break;
+                case FileOp::WRITE:
+                    handleWrite(request, response);
+                    break;
+                case FileOp::APPEND:
+                    handleAppend(request, response);
+                    // Producers may hand over a pooled block through the
+                    // queue (e.g. BulkTransfer); the bytes are buffered
+                    // now, so drop their reference for them
+                    if (BufferPool::getInstance().owns(request.data)) {
+                        BufferPool::getInstance().release(request.data);
                     }
-                    xSemaphoreGive(fileMutex);
-                }
-                
-                // Send response
-                xQueueSend(responseQueue, &response, portMAX_DELAY);
+                    break;
+                case FileOp::FLUSH:
+                    handleFlush(request, response);
+                    break;
+                // Add other operations as needed
+            }
+            TRACE_RECORD(TRACE_FILE_HANDLER, handlerStart);
+            xSemaphoreGiveRecursive(fileMutex);
+        }
+        if (request.notify) {
+            xQueueSend(responseQueue, &response, portMAX_DELAY);
+        }
+    }
+
+    // Drain pending high-priority requests; called between chunks of long
+    // low-priority operations so urgent I/O is not stuck behind them
+    void serviceHighPriority() {
+        FileRequest* request;
+        while (xQueueReceive(highQueue, &request, 0) == pdTRUE) {
+            dispatch(*request);
+            releaseRequest(request);
+        }
+    }
+
+    // Read cache: repeat reads of small config/metadata files are served
+    // from RAM instead of a full SD transaction under fileMutex. Entries
+    // hold a BufferPool reference; cache hits hand out another reference
+    // to the same block, so a hit is zero-copy. Invalidated on write,
+    // append, or mtime change.
+    static constexpr size_t READ_CACHE_ENTRIES = 8;
+    static constexpr size_t READ_CACHE_BUDGET = 16 * 1024;
+    static constexpr size_t READ_CACHE_MAX_FILE = 8 * 1024;
+
+    struct CacheEntry {
+        char filename[APPEND_NAME_MAX];
+        uint8_t* data;
+        size_t length;
+        time_t mtime;
+        uint32_t lastUse;
+        bool valid;
+    };
+    CacheEntry readCache[READ_CACHE_ENTRIES] = {};
+    size_t cacheBytes = 0;
+    uint32_t cacheClock = 0;
+
+    CacheEntry* cacheLookup(const char* filename) {
+        for (size_t i = 0; i < READ_CACHE_ENTRIES; i++) {
+            if (readCache[i].valid &&
+                strncmp(readCache[i].filename, filename, APPEND_NAME_MAX) == 0) {
+                return &readCache[i];
+            }
+        }
+        return nullptr;
+    }
+
+    void cacheDrop(CacheEntry& entry) {
+        BufferPool::getInstance().release(entry.data);
+        cacheBytes -= entry.length;
+        entry.valid = false;
+    }
+
+    void invalidateCache(const char* filename) {
+        CacheEntry* entry = cacheLookup(filename);
+        if (entry != nullptr) {
+            cacheDrop(*entry);
+        }
+    }
+
+    void cacheEvictLRU() {
+        CacheEntry* victim = nullptr;
+        for (size_t i = 0; i < READ_CACHE_ENTRIES; i++) {
+            if (readCache[i].valid &&
+                (victim == nullptr || readCache[i].lastUse < victim->lastUse)) {
+                victim = &readCache[i];
             }
         }
+        if (victim != nullptr) {
+            cacheDrop(*victim);
+        }
+    }
+
+    void cacheInsert(const char* filename, uint8_t* data, size_t length, time_t mtime) {
+        if (length > READ_CACHE_MAX_FILE) return;
+        invalidateCache(filename);
+
+        // Evict until the byte budget and a slot are available
+        while (cacheBytes + length > READ_CACHE_BUDGET && cacheBytes > 0) {
+            cacheEvictLRU();
+        }
+        CacheEntry* slot = nullptr;
+        for (size_t i = 0; i < READ_CACHE_ENTRIES; i++) {
+            if (!readCache[i].valid) { slot = &readCache[i]; break; }
+        }
+        if (slot == nullptr) {
+            cacheEvictLRU();
+            for (size_t i = 0; i < READ_CACHE_ENTRIES; i++) {
+                if (!readCache[i].valid) { slot = &readCache[i]; break; }
+            }
+        }
+        if (slot == nullptr) return;
+
+        BufferPool::getInstance().retain(data);
+        strncpy(slot->filename, filename, APPEND_NAME_MAX - 1);
+        slot->filename[APPEND_NAME_MAX - 1] = '\0';
+        slot->data = data;
+        slot->length = length;
+        slot->mtime = mtime;
+        slot->lastUse = ++cacheClock;
+        slot->valid = true;
+        cacheBytes += length;
     }
 
     // Handle file read operation
     void handleRead(const FileRequest& request, FileResponse& response) {
-        FILE* file = fopen(request.filename.c_str(), "rb");
+        // Serve from cache when the file is unchanged on disk
+        struct stat st;
+        bool haveStat = (stat(request.filename, &st) == 0);
+        CacheEntry* cached = cacheLookup(request.filename);
+        if (cached != nullptr) {
+            if (haveStat && cached->mtime == st.st_mtime) {
+                BufferPool::getInstance().retain(cached->data);
+                cached->lastUse = ++cacheClock;
+                response = {
+                    .success = true,
+                    .message = "Success",
+                    .data = cached->data,
+                    .length = cached->length,
+                    .requestId = request.requestId
+                };
+                return;
+            }
+            cacheDrop(*cached); // Stale: mtime moved or file is gone
+        }
+
+        FILE* file = fopen(request.filename, "rb");
         if (file == nullptr) {
             response = {
                 .success = false,
@@ -141,11 +447,38 @@ private:
         size_t size = ftell(file);
         fseek(file, 0, SEEK_SET);
 
-        // Allocate buffer and read file
-        uint8_t* buffer = new uint8_t[size];
-        size_t read = fread(buffer, 1, size, file);
+        // Read into a pooled buffer (fixed blocks, no heap fragmentation)
+        uint8_t* buffer = BufferPool::getInstance().alloc(size);
+        if (buffer == nullptr) {
+            fclose(file);
+            response = {
+                .success = false,
+                .message = "Buffer pool exhausted",
+                .data = nullptr,
+                .length = 0,
+                .requestId = request.requestId
+            };
+            return;
+        }
+
+        // Pool blocks are DMA-capable and aligned: drop the stdio staging
+        // buffer so fread lands directly in our buffer, and read in
+        // DMA-maximum chunks to keep each SPI transaction on the fast path
+        setvbuf(file, nullptr, _IONBF, 0);
+        size_t read = 0;
+        while (read < size) {
+            size_t chunk = size - read;
+            if (chunk > SD_DMA_CHUNK) chunk = SD_DMA_CHUNK;
+            size_t got = fread(buffer + read, 1, chunk, file);
+            read += got;
+            if (got < chunk) break;
+        }
         fclose(file);
 
+        if (read == size && haveStat) {
+            cacheInsert(request.filename, buffer, read, st.st_mtime);
+        }
+
         response = {
             .success = (read == size),
             .message = (read == size) ? "Success" : "Read error",
@@ -155,9 +488,193 @@ private:
         };
     }
 
+    // Handle streaming read: one pooled chunk in flight with the consumer
+    // while the next is being filled from SD. All but the final chunk are
+    // enqueued here; the final one goes out through the normal fileTask send.
+    void handleReadStream(const FileRequest& request, FileResponse& response) {
+        size_t chunkSize = request.length;
+        if (chunkSize == 0 || chunkSize > BufferPool::BLOCK_SIZE * 4) {
+            chunkSize = BufferPool::BLOCK_SIZE;
+        }
+
+        FILE* file = fopen(request.filename, "rb");
+        if (file == nullptr) {
+            response = {
+                .success = false,
+                .message = "Failed to open file",
+                .data = nullptr,
+                .length = 0,
+                .requestId = request.requestId,
+                .offset = 0,
+                .endOfStream = true
+            };
+            return;
+        }
+
+        // Unbuffered: chunks DMA straight into the aligned pool blocks
+        setvbuf(file, nullptr, _IONBF, 0);
+
+        size_t offset = 0;
+        while (true) {
+            uint8_t* buffer = BufferPool::getInstance().alloc(chunkSize);
+            while (buffer == nullptr) {
+                // Consumer still holds earlier chunks; wait for a block
+                vTaskDelay(pdMS_TO_TICKS(5));
+                buffer = BufferPool::getInstance().alloc(chunkSize);
+            }
+
+            size_t read = fread(buffer, 1, chunkSize, file);
+            bool last = (read < chunkSize) || feof(file);
+
+            response = {
+                .success = true,
+                .message = last ? "End of stream" : "Chunk",
+                .data = buffer,
+                .length = read,
+                .requestId = request.requestId,
+                .offset = offset,
+                .endOfStream = last
+            };
+            offset += read;
+
+            if (last) break;
+            xQueueSend(responseQueue, &response, portMAX_DELAY);
+
+            // Let urgent requests cut in between chunks of a long stream
+            if (request.priority != RequestPriority::HIGH) {
+                serviceHighPriority();
+            }
+        }
+        fclose(file);
+    }
+
+    // Append a record to the write-behind buffer; the SD is touched only
+    // when the stream fills (or ages out / is flushed)
+    void handleAppend(const FileRequest& request, FileResponse& response) {
+        invalidateCache(request.filename);
+        AppendStream* stream = streamFor(request.filename);
+        if (stream == nullptr) {
+            response = {
+                .success = false,
+                .message = "No free append stream",
+                .data = nullptr,
+                .length = 0,
+                .requestId = request.requestId
+            };
+            return;
+        }
+
+        // Records larger than the buffer write through directly
+        if (request.length > APPEND_BUFFER_SIZE) {
+            commitStream(*stream);
+            bool ok = appendToFile(stream->filename, request.data, request.length);
+            response = {
+                .success = ok,
+                .message = ok ? "Success" : "Write error",
+                .data = nullptr,
+                .length = ok ? request.length : 0,
+                .requestId = request.requestId
+            };
+            return;
+        }
+
+        if (stream->used + request.length > APPEND_BUFFER_SIZE) {
+            commitStream(*stream);
+        }
+        if (stream->used == 0) {
+            stream->firstWriteTick = xTaskGetTickCount();
+        }
+        memcpy(stream->buffer + stream->used, request.data, request.length);
+        stream->used += request.length;
+
+        if (stream->used >= APPEND_BUFFER_SIZE) {
+            commitStream(*stream);
+        }
+
+        response = {
+            .success = true,
+            .message = "Buffered",
+            .data = nullptr,
+            .length = request.length,
+            .requestId = request.requestId
+        };
+    }
+
+    void handleFlush(const FileRequest& request, FileResponse& response) {
+        bool ok = true;
+        for (size_t i = 0; i < APPEND_STREAMS; i++) {
+            if (!appendStreams[i].active) continue;
+            if (request.filename[0] == '\0' ||
+                strncmp(appendStreams[i].filename, request.filename,
+                        APPEND_NAME_MAX) == 0) {
+                ok = commitStream(appendStreams[i]) && ok;
+                // FLUSH ends the stream: release the slot so another
+                // file can claim it (there are only APPEND_STREAMS)
+                appendStreams[i].active = false;
+            }
+        }
+        response = {
+            .success = ok,
+            .message = ok ? "Flushed" : "Flush error",
+            .data = nullptr,
+            .length = 0,
+            .requestId = request.requestId
+        };
+    }
+
+    // Find the stream buffering this file, or claim a free slot
+    AppendStream* streamFor(const char* filename) {
+        for (size_t i = 0; i < APPEND_STREAMS; i++) {
+            if (appendStreams[i].active &&
+                strncmp(appendStreams[i].filename, filename, APPEND_NAME_MAX) == 0) {
+                return &appendStreams[i];
+            }
+        }
+        for (size_t i = 0; i < APPEND_STREAMS; i++) {
+            if (!appendStreams[i].active) {
+                strncpy(appendStreams[i].filename, filename, APPEND_NAME_MAX - 1);
+                appendStreams[i].filename[APPEND_NAME_MAX - 1] = '\0';
+                appendStreams[i].used = 0;
+                appendStreams[i].active = true;
+                return &appendStreams[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // One burst write of everything buffered for this stream
+    bool commitStream(AppendStream& stream) {
+        if (stream.used == 0) return true;
+        bool ok = appendToFile(stream.filename, stream.buffer, stream.used);
+        stream.used = 0;
+        return ok;
+    }
+
+    void commitAgedAppendStreams() {
+        TickType_t now = xTaskGetTickCount();
+        for (size_t i = 0; i < APPEND_STREAMS; i++) {
+            if (appendStreams[i].active && appendStreams[i].used > 0 &&
+                now - appendStreams[i].firstWriteTick >= APPEND_MAX_AGE_TICKS) {
+                commitStream(appendStreams[i]);
+                // Aged out means the producer has gone quiet; free the
+                // slot. A late append just claims a stream again.
+                appendStreams[i].active = false;
+            }
+        }
+    }
+
+    bool appendToFile(const char* filename, const uint8_t* data, size_t length) {
+        FILE* file = fopen(filename, "ab");
+        if (file == nullptr) return false;
+        size_t written = fwrite(data, 1, length, file);
+        fclose(file);
+        return written == length;
+    }
+
     // Handle file write operation
     void handleWrite(const FileRequest& request, FileResponse& response) {
-        FILE* file = fopen(request.filename.c_str(), "wb");
+        invalidateCache(request.filename);
+        FILE* file = fopen(request.filename, "wb");
         if (file == nullptr) {
             response = {
                 .success = false,
@@ -4,10 +4,17 @@
 #include "freertos/queue.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "esp_partition.h"
+#include "esp_log.h"
+#include "ArenaPool.hpp"
+#include "BufferPool.hpp"
+#include "RequestPriority.hpp"
+#include "SystemKernel.hpp"
+#include "Trace.hpp"
 #include "tensorflow/lite/micro/micro_interpreter.h"
-#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
-#include <map>
-#include <string>
+#include "ModelTraits.hpp"
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
+#include "tensorflow/lite/schema/schema_generated.h"
 
 // Model states
 enum class ModelState {
@@ -23,66 +30,171 @@ enum class ModelOp {
     LOAD,
     UNLOAD,
     RUN,
+    RUN_BATCH,
     STATUS
 };
 
+constexpr size_t MODEL_ID_MAX = 32;
+
+// Models are addressed by a small integer handle (the registry slot index)
+// returned in the LOAD response. The string ID is a registration-time
+// convenience only; the hot inference path passes just the handle and
+// performs no heap allocation or string compare. Requests live in a
+// fixed pool inside ModelRuntime; only the pointer travels through the
+// queues (see FileManager.hpp for the same protocol).
 struct ModelRequest {
     ModelOp operation;
-    std::string modelId;
+    char modelId[MODEL_ID_MAX]; // Registration-time only; empty on the hot path
+    int32_t modelHandle;     // Registry slot; INVALID_MODEL to resolve by ID
     uint8_t* inputData;
-    size_t inputLength;
+    size_t inputLength;      // Bytes per frame for RUN_BATCH
+    size_t batchCount;       // Number of contiguous frames (RUN_BATCH only)
     uint32_t requestId;
+    int64_t deadlineUs;      // Absolute esp_timer deadline; 0 = none
+    RequestPriority priority;
+    uint32_t traceUs;        // Enqueue wall-clock stamp (queue-wait tracing)
 };
 
+// `outputData` is a BufferPool buffer; the consumer must release it via
+// BufferPool::getInstance().release() (see FileManager.hpp for the same
+// contract on file reads). `message` points at a literal or at the
+// runtime's error buffer; consume it before the next response.
 struct ModelResponse {
     bool success;
-    std::string message;
+    const char* message;
     uint8_t* outputData;
     size_t outputLength;
     uint32_t requestId;
     ModelState state;
+    int32_t modelHandle;     // Valid in LOAD responses: use for inference
 };
 
 class ModelRuntime {
 public:
+    static constexpr size_t MAX_MODELS = 8;
+    static constexpr int32_t INVALID_MODEL = -1;
+
     ModelRuntime(size_t queueSize = 5) {
-        requestQueue = xQueueCreate(queueSize, sizeof(ModelRequest));
+        // Per-priority queues plus a queue set, mirroring FileManager:
+        // urgent inference never waits behind a queued bulk batch. The
+        // queues carry pointers into requestPool; the free list doubles
+        // as producer backpressure.
+        highQueue = xQueueCreate(queueSize, sizeof(ModelRequest*));
+        normalQueue = xQueueCreate(queueSize, sizeof(ModelRequest*));
         responseQueue = xQueueCreate(queueSize, sizeof(ModelResponse));
-        modelMutex = xSemaphoreCreateMutex();
-        
-        xTaskCreate(
+        requestQueueSet = xQueueCreateSet(queueSize * 2);
+        xQueueAddToSet(highQueue, requestQueueSet);
+        xQueueAddToSet(normalQueue, requestQueueSet);
+        modelMutex = xSemaphoreCreateRecursiveMutex();
+
+        freeRequests = xQueueCreate(REQUEST_POOL_SIZE, sizeof(ModelRequest*));
+        for (size_t i = 0; i < REQUEST_POOL_SIZE; i++) {
+            ModelRequest* slot = &requestPool[i];
+            xQueueSend(freeRequests, &slot, 0);
+        }
+
+        // Hand the kernel a way to reclaim warm-cache RAM under pressure
+        SystemKernel::getInstance().registerMemoryPressureHandler(
+            [](size_t bytesNeeded, void* arg) -> size_t {
+                return static_cast<ModelRuntime*>(arg)->reclaimModels(bytesNeeded);
+            },
+            this);
+
+        // Pin to the ML core so inference never time-slices with SD I/O
+        xTaskCreatePinnedToCore(
             modelTaskWrapper,
             "ModelTask",
             16384, // Larger stack for ML operations
             this,
             5,
-            &modelTaskHandle
+            &modelTaskHandle,
+            SystemKernel::coreForDomain(TaskDomain::ML)
         );
     }
 
-    // Async model loading request
-    bool requestModelLoad(const std::string& modelId, uint32_t requestId) {
-        ModelRequest request = {
-            .operation = ModelOp::LOAD,
-            .modelId = modelId,
-            .inputData = nullptr,
-            .inputLength = 0,
-            .requestId = requestId
-        };
-        return xQueueSend(requestQueue, &request, portMAX_DELAY) == pdTRUE;
-    }
-
-    // Async inference request
-    bool requestInference(const std::string& modelId, uint8_t* inputData, 
-                         size_t inputLength, uint32_t requestId) {
-        ModelRequest request = {
-            .operation = ModelOp::RUN,
-            .modelId = modelId,
-            .inputData = inputData,
-            .inputLength = inputLength,
-            .requestId = requestId
-        };
-        return xQueueSend(requestQueue, &request, portMAX_DELAY) == pdTRUE;
+    // Async model loading request; the LOAD response carries the handle to
+    // use for all subsequent inference on this model
+    bool requestModelLoad(const char* modelId, uint32_t requestId,
+                          RequestPriority priority = RequestPriority::NORMAL) {
+        ModelRequest* request = acquireRequest();
+        request->operation = ModelOp::LOAD;
+        copyId(request->modelId, modelId);
+        request->modelHandle = INVALID_MODEL;
+        request->inputData = nullptr;
+        request->inputLength = 0;
+        request->batchCount = 0;
+        request->requestId = requestId;
+        request->deadlineUs = 0;
+        request->priority = priority;
+        return enqueue(request);
+    }
+
+    // Async inference request: handle-addressed hot path, zero heap
+    // allocation and O(1) registry lookup. An optional absolute deadline
+    // (esp_timer microseconds) breaks priority ties in the scheduler.
+    bool requestInference(int32_t modelHandle, uint8_t* inputData,
+                         size_t inputLength, uint32_t requestId,
+                         RequestPriority priority = RequestPriority::NORMAL,
+                         int64_t deadlineUs = 0) {
+        ModelRequest* request = acquireRequest();
+        request->operation = ModelOp::RUN;
+        request->modelId[0] = '\0';
+        request->modelHandle = modelHandle;
+        request->inputData = inputData;
+        request->inputLength = inputLength;
+        request->batchCount = 0;
+        request->requestId = requestId;
+        request->deadlineUs = deadlineUs;
+        request->priority = priority;
+        return enqueue(request);
+    }
+
+    // Convenience string-ID overload; resolves in the model task (pays a
+    // registration-table scan -- use the handle overload on hot paths)
+    bool requestInference(const char* modelId, uint8_t* inputData,
+                         size_t inputLength, uint32_t requestId,
+                         RequestPriority priority = RequestPriority::NORMAL) {
+        ModelRequest* request = acquireRequest();
+        request->operation = ModelOp::RUN;
+        copyId(request->modelId, modelId);
+        request->modelHandle = INVALID_MODEL;
+        request->inputData = inputData;
+        request->inputLength = inputLength;
+        request->batchCount = 0;
+        request->requestId = requestId;
+        request->deadlineUs = 0;
+        request->priority = priority;
+        return enqueue(request);
+    }
+
+    // Async batched inference: `frames` is `frameCount` contiguous samples of
+    // `frameLength` bytes each, run back-to-back in a single task wakeup.
+    // One ModelResponse is emitted per frame, in order, under one requestId.
+    bool requestInferenceBatch(int32_t modelHandle, uint8_t* frames,
+                               size_t frameLength, size_t frameCount,
+                               uint32_t requestId,
+                               RequestPriority priority = RequestPriority::NORMAL) {
+        ModelRequest* request = acquireRequest();
+        request->operation = ModelOp::RUN_BATCH;
+        request->modelId[0] = '\0';
+        request->modelHandle = modelHandle;
+        request->inputData = frames;
+        request->inputLength = frameLength;
+        request->batchCount = frameCount;
+        request->requestId = requestId;
+        request->deadlineUs = 0;
+        request->priority = priority;
+        return enqueue(request);
+    }
+
+    // Registration-time lookup of a loaded model's handle by string ID
+    int32_t resolveModel(const char* modelId) {
+        int32_t handle = INVALID_MODEL;
+        if (xSemaphoreTakeRecursive(modelMutex, portMAX_DELAY) == pdTRUE) {
+            handle = findSlot(modelId);
+            xSemaphoreGiveRecursive(modelMutex);
+        }
+        return handle;
     }
 
     // Get response from model operations
@@ -90,93 +202,481 @@ public:
         return xQueueReceive(responseQueue, &response, timeout) == pdTRUE;
     }
 
+    // --- Swarm offload support ---------------------------------------
+    // When a RUN request targets a model this node does not have loaded
+    // (or the scheduler is backed up), the registered handler may ship it
+    // to a peer. It returns true if the request was taken; the remote
+    // result then arrives later through injectResponse().
+    using OffloadHandler = bool (*)(const char* modelId, uint8_t* inputData,
+                                    size_t inputLength, uint32_t requestId,
+                                    void* arg);
+
+    void registerOffloadHandler(OffloadHandler handler, void* arg) {
+        offloadHandler = handler;
+        offloadArg = arg;
+    }
+
+    // Surface a remotely computed result through the normal response queue
+    bool injectResponse(const ModelResponse& response) {
+        return xQueueSend(responseQueue, &response, portMAX_DELAY) == pdTRUE;
+    }
+
+    // Serving side of the offload path: run one inference on behalf of a
+    // peer, synchronously, serialized against modelTask by modelMutex.
+    bool executeForOffload(const char* modelId, const uint8_t* input,
+                           size_t inputLength, uint8_t* output,
+                           size_t outputCap, size_t* outputLength) {
+        bool ok = false;
+        if (xSemaphoreTakeRecursive(modelMutex, portMAX_DELAY) == pdTRUE) {
+            int32_t handle = findSlot(modelId);
+            if (handle != INVALID_MODEL) {
+                ModelContext& context = models[handle].context;
+                models[handle].lastUsed = ++useClock;
+                auto* inputTensor = context.interpreter->input(0);
+                auto* outputTensor = context.interpreter->output(0);
+                if (inputLength <= inputTensor->bytes &&
+                    outputTensor->bytes <= outputCap) {
+                    memcpy(inputTensor->data.raw, input, inputLength);
+                    if (context.interpreter->Invoke() == kTfLiteOk) {
+                        memcpy(output, outputTensor->data.raw, outputTensor->bytes);
+                        *outputLength = outputTensor->bytes;
+                        ok = true;
+                    }
+                }
+            }
+            xSemaphoreGiveRecursive(modelMutex);
+        }
+        return ok;
+    }
+
 private:
+    // Cooperative yield point: TFLite micro drives the profiler interface
+    // around every operator invocation, which gives us a safe boundary
+    // inside a long Invoke() to run a short urgent inference on a
+    // different model. Same-model requests still wait out the Invoke.
+    class OpYieldHook : public tflite::MicroProfilerInterface {
+    public:
+        ModelRuntime* runtime = nullptr;
+        int32_t owner = -1;
+
+        uint32_t BeginEvent(const char* tag) override { return 0; }
+        void EndEvent(uint32_t handle) override {
+            if (runtime != nullptr) {
+                runtime->onOpBoundary(owner);
+            }
+        }
+    };
+
     struct ModelContext {
         std::unique_ptr<tflite::MicroInterpreter> interpreter;
-        std::unique_ptr<tflite::MicroMutableOpResolver<10>> resolver;
+        // Specialized per model id (ModelTraits), minimally sized
+        std::unique_ptr<tflite::MicroOpResolver> resolver;
+        OpYieldHook yieldHook;
         const tflite::Model* model;
         uint8_t* tensorArena;
         size_t tensorArenaSize;
         ModelState state;
+        // Set when the model flatbuffer is memory-mapped from flash (zero-copy)
+        esp_partition_mmap_handle_t mmapHandle;
+        bool mappedFromFlash;
+        // Heap copy used only on the SD fallback path
+        uint8_t* modelData;
     };
 
-    QueueHandle_t requestQueue;
+    // Fixed-capacity registry: contiguous slots, handle == index. The hot
+    // path never touches a map or a std::string.
+    struct ModelSlot {
+        ModelContext context;
+        char id[MODEL_ID_MAX];
+        bool used;
+        uint32_t lastUsed;   // Warm-cache LRU stamp
+    };
+
+    // Warm cache: loaded models stay resident so reuse skips the 700 ms
+    // SD-load/AllocateTensors path, bounded by this arena-byte budget.
+    // LRU models are evicted when the budget or the kernel's memory
+    // pressure signal demands it.
+    static constexpr size_t WARM_CACHE_BUDGET = 160 * 1024;
+
+    QueueHandle_t highQueue;
+    QueueHandle_t normalQueue;
     QueueHandle_t responseQueue;
+    QueueSetHandle_t requestQueueSet;
     SemaphoreHandle_t modelMutex;
     TaskHandle_t modelTaskHandle;
-    std::map<std::string, ModelContext> loadedModels;
+    ModelSlot models[MAX_MODELS] = {};
+    ArenaPool arenaPool;
+
+    const char* idForHandle(int32_t handle) {
+        if (handle < 0 || handle >= (int32_t)MAX_MODELS || !models[handle].used) {
+            return nullptr;
+        }
+        return models[handle].id;
+    }
+
+    // Registration-time scan; not used on the handle-addressed hot path
+    int32_t findSlot(const char* modelId) {
+        for (size_t i = 0; i < MAX_MODELS; i++) {
+            if (models[i].used && strncmp(models[i].id, modelId, MODEL_ID_MAX) == 0) {
+                return (int32_t)i;
+            }
+        }
+        return INVALID_MODEL;
+    }
+
+    // Resolve a request to its registry slot: O(1) array index when the
+    // handle is set, ID scan only for the string-convenience overloads
+    ModelContext* contextFor(const ModelRequest& request) {
+        int32_t handle = request.modelHandle;
+        if (handle == INVALID_MODEL && request.modelId[0] != '\0') {
+            handle = findSlot(request.modelId);
+        }
+        if (handle < 0 || handle >= (int32_t)MAX_MODELS || !models[handle].used) {
+            return nullptr;
+        }
+        models[handle].lastUsed = ++useClock;
+        return &models[handle].context;
+    }
+
+    uint32_t useClock = 0;
+
+    size_t residentArenaBytes() {
+        size_t total = 0;
+        for (size_t i = 0; i < MAX_MODELS; i++) {
+            if (models[i].used) total += models[i].context.tensorArenaSize;
+        }
+        return total;
+    }
+
+    // Free the least-recently-used resident model that is not mid-Invoke.
+    // Returns the bytes given back (arena plus any SD heap copy).
+    size_t evictLRUModel() {
+        int victim = -1;
+        for (size_t i = 0; i < MAX_MODELS; i++) {
+            if (models[i].used && models[i].context.state != ModelState::RUNNING &&
+                (victim < 0 || models[i].lastUsed < models[victim].lastUsed)) {
+                victim = (int)i;
+            }
+        }
+        if (victim < 0) return 0;
+
+        ModelContext& context = models[victim].context;
+        size_t freed = context.tensorArenaSize;
+        ESP_LOGW("ModelRuntime", "Evicting model '%s' (%u bytes) from warm cache",
+                 models[victim].id, (unsigned)freed);
+
+        context.interpreter.reset();
+        context.resolver.reset();
+        releaseModelStorage(context);
+        arenaPool.checkin(context.tensorArena);
+        context.tensorArena = nullptr;
+        context.state = ModelState::UNLOADED;
+        models[victim].used = false;
+        models[victim].id[0] = '\0';
+        return freed;
+    }
+
+    // Kernel memory-pressure callback: evict LRU models until the request
+    // is covered or nothing evictable remains
+    size_t reclaimModels(size_t bytesNeeded) {
+        size_t freed = 0;
+        // Bounded take: this runs on the kernel's monitor path, and an
+        // inference can hold modelMutex for hundreds of milliseconds.
+        // Better to report nothing freed this round than to stall the
+        // caller behind an Invoke; pressure persists and we get called
+        // again.
+        if (xSemaphoreTakeRecursive(modelMutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+            while (freed < bytesNeeded) {
+                size_t got = evictLRUModel();
+                if (got == 0) break;
+                freed += got;
+            }
+            xSemaphoreGiveRecursive(modelMutex);
+        }
+        return freed;
+    }
+
+    // Fixed request pool: pointer-sized enqueues, zero heap allocation.
+    // Slots return to the free list the moment the request is copied into
+    // the pending table or dispatched.
+    static constexpr size_t REQUEST_POOL_SIZE = 16;
+    ModelRequest requestPool[REQUEST_POOL_SIZE];
+    QueueHandle_t freeRequests;
+
+    ModelRequest* acquireRequest() {
+        ModelRequest* request;
+        xQueueReceive(freeRequests, &request, portMAX_DELAY);
+        return request;
+    }
+
+    void releaseRequest(ModelRequest* request) {
+        xQueueSend(freeRequests, &request, portMAX_DELAY);
+    }
+
+    static void copyId(char* dst, const char* src) {
+        strncpy(dst, src, MODEL_ID_MAX - 1);
+        dst[MODEL_ID_MAX - 1] = '\0';
+    }
+
+    // Exception messages are copied here before the catch scope unwinds;
+    // responses point at this buffer (single model task, so one is enough)
+    char lastError[64];
+
+    const char* stashError(const char* what) {
+        strncpy(lastError, what, sizeof(lastError) - 1);
+        lastError[sizeof(lastError) - 1] = '\0';
+        return lastError;
+    }
+
+    bool enqueue(ModelRequest* request) {
+        TRACE_STAMP_US(request->traceUs);
+        QueueHandle_t queue = (request->priority == RequestPriority::HIGH)
+                                  ? highQueue : normalQueue;
+        return xQueueSend(queue, &request, portMAX_DELAY) == pdTRUE;
+    }
 
     static void modelTaskWrapper(void* params) {
         static_cast<ModelRuntime*>(params)->modelTask();
     }
 
-    void modelTask() {
+    // Scheduler state: requests drained from the ingress queues wait here
+    // until selected by policy (priority first, then earliest deadline,
+    // then arrival order)
+    static constexpr size_t PENDING_MAX = 16;
+    struct PendingRequest {
         ModelRequest request;
-        ModelResponse response;
+        uint32_t seq;
+    };
+    PendingRequest pending[PENDING_MAX];
+    size_t pendingCount = 0;
+    uint32_t arrivalSeq = 0;
+    bool inPreemption = false;
+
+    void drainIngress() {
+        ModelRequest* request;
+        while (pendingCount < PENDING_MAX &&
+               (xQueueReceive(highQueue, &request, 0) == pdTRUE ||
+                xQueueReceive(normalQueue, &request, 0) == pdTRUE)) {
+            pending[pendingCount].request = *request; // POD copy, no heap
+            pending[pendingCount].seq = arrivalSeq++;
+            pendingCount++;
+            releaseRequest(request);
+        }
+    }
+
+    int selectBest() {
+        int best = -1;
+        for (size_t i = 0; i < pendingCount; i++) {
+            if (best < 0) { best = (int)i; continue; }
+            const ModelRequest& a = pending[i].request;
+            const ModelRequest& b = pending[best].request;
+            if (a.priority != b.priority) {
+                if (a.priority == RequestPriority::HIGH) best = (int)i;
+                continue;
+            }
+            // 0 means no deadline: sorts after any real one
+            int64_t da = a.deadlineUs ? a.deadlineUs : INT64_MAX;
+            int64_t db = b.deadlineUs ? b.deadlineUs : INT64_MAX;
+            if (da != db) {
+                if (da < db) best = (int)i;
+                continue;
+            }
+            if (pending[i].seq < pending[best].seq) best = (int)i;
+        }
+        return best;
+    }
+
+    void modelTask() {
+        // Model loads read storage; requests queued during boot just
+        // wait here until the mounts finish
+        SystemKernel::getInstance().waitReady(SystemKernel::READY_STORAGE);
 
         while (true) {
-            if (xQueueReceive(requestQueue, &request, portMAX_DELAY) == pdTRUE) {
-                if (xSemaphoreTake(modelMutex, portMAX_DELAY) == pdTRUE) {
-                    switch (request.operation) {
-                        case ModelOp::LOAD:
-                            handleModelLoad(request, response);
-                            break;
-                        case ModelOp::RUN:
-                            handleInference(request, response);
-                            break;
-                        case ModelOp::UNLOAD:
-                            handleModelUnload(request, response);
-                            break;
-                    }
-                    xSemaphoreGive(modelMutex);
-                }
-                xQueueSend(responseQueue, &response, portMAX_DELAY);
+            if (pendingCount == 0) {
+                xQueueSelectFromSet(requestQueueSet, portMAX_DELAY);
             }
+            drainIngress();
+
+            int best = selectBest();
+            if (best >= 0) {
+                ModelRequest request = pending[best].request;
+                pending[best] = pending[--pendingCount];
+                dispatch(request);
+            }
+        }
+    }
+
+    // Execute one request and send its response. Re-entrant (recursive
+    // mutex) so batch handlers can dispatch urgent work between frames.
+    OffloadHandler offloadHandler = nullptr;
+    void* offloadArg = nullptr;
+    // Scheduler depth at which loaded-model requests also become offload
+    // candidates (gateways idle while leaves saturate otherwise)
+    static constexpr size_t OFFLOAD_DEPTH_THRESHOLD = 8;
+
+    void dispatch(const ModelRequest& request) {
+        ModelResponse response;
+        // Suppression is per dispatch, returned by the handler: dispatch
+        // re-enters through onOpBoundary/serviceHighPriority, and a
+        // member flag set by a nested offloaded request would silently
+        // swallow the outer request's response
+        bool suppressed = false;
+        TRACE_MARK(mutexStart);
+        if (xSemaphoreTakeRecursive(modelMutex, portMAX_DELAY) == pdTRUE) {
+            TRACE_RECORD(TRACE_MODEL_MUTEX_WAIT, mutexStart);
+            switch (request.operation) {
+                case ModelOp::LOAD:
+                    handleModelLoad(request, response);
+                    break;
+                case ModelOp::RUN:
+                    suppressed = handleInference(request, response);
+                    break;
+                case ModelOp::RUN_BATCH:
+                    handleInferenceBatch(request, response);
+                    break;
+                case ModelOp::UNLOAD:
+                    handleModelUnload(request, response);
+                    break;
+            }
+            xSemaphoreGiveRecursive(modelMutex);
+        }
+        // Offloaded requests answer later via injectResponse()
+        if (!suppressed) {
+            TRACE_MARK(responseStart);
+            xQueueSend(responseQueue, &response, portMAX_DELAY);
+            TRACE_RECORD(TRACE_MODEL_RESPONSE, responseStart);
+        }
+    }
+
+    // Called at every operator boundary of a running Invoke(). If an
+    // urgent RUN for a *different* model is waiting, run it to completion
+    // here -- a 5 ms keyword-spotting inference no longer waits out a
+    // 300 ms vision Invoke. Recursion is capped at one level.
+    void onOpBoundary(int32_t ownerHandle) {
+        // The hook fires on whatever task is driving Invoke --
+        // executeForOffload runs it on the beacon task. Preemption
+        // re-enters dispatch and scheduler state that belong to the
+        // model task alone, so only that task may take this path.
+        if (xTaskGetCurrentTaskHandle() != modelTaskHandle) return;
+        if (inPreemption) return;
+
+        ModelRequest* urgent;
+        if (xQueuePeek(highQueue, &urgent, 0) != pdTRUE) return;
+        if (urgent->operation != ModelOp::RUN) return;
+
+        int32_t target = urgent->modelHandle;
+        if (target == INVALID_MODEL && urgent->modelId[0] != '\0') {
+            target = findSlot(urgent->modelId);
+        }
+        if (target == INVALID_MODEL || target == ownerHandle) return;
+
+        if (xQueueReceive(highQueue, &urgent, 0) == pdTRUE) {
+            inPreemption = true;
+            dispatch(*urgent);
+            releaseRequest(urgent);
+            inPreemption = false;
+        }
+    }
+
+    // Drain pending high-priority requests between frames of a long batch.
+    // Returns true if anything ran (the caller's staged input tensor may
+    // have been clobbered and must be restaged).
+    bool serviceHighPriority() {
+        ModelRequest* request;
+        bool ran = false;
+        while (xQueueReceive(highQueue, &request, 0) == pdTRUE) {
+            dispatch(*request);
+            releaseRequest(request);
+            ran = true;
         }
+        return ran;
     }
 
     void handleModelLoad(const ModelRequest& request, ModelResponse& response) {
         // Check if model is already loaded
-        if (loadedModels.find(request.modelId) != loadedModels.end()) {
+        int32_t existing = findSlot(request.modelId);
+        if (existing != INVALID_MODEL) {
             response = {
                 .success = true,
                 .message = "Model already loaded",
                 .outputData = nullptr,
                 .outputLength = 0,
                 .requestId = request.requestId,
-                .state = ModelState::READY
+                .state = ModelState::READY,
+                .modelHandle = existing
+            };
+            return;
+        }
+
+        // Claim a free registry slot; its index becomes the handle
+        int32_t handle = INVALID_MODEL;
+        for (size_t i = 0; i < MAX_MODELS; i++) {
+            if (!models[i].used) {
+                handle = (int32_t)i;
+                break;
+            }
+        }
+        if (handle == INVALID_MODEL) {
+            response = {
+                .success = false,
+                .message = "Model registry full",
+                .outputData = nullptr,
+                .outputLength = 0,
+                .requestId = request.requestId,
+                .state = ModelState::ERROR,
+                .modelHandle = INVALID_MODEL
             };
             return;
         }
 
         try {
-            ModelContext context;
+            ModelContext& context = models[handle].context;
             context.state = ModelState::LOADING;
-            
-            // Load model from filesystem (implementation depends on storage system)
-            context.model = loadModelFromStorage(request.modelId);
+            context.mappedFromFlash = false;
+            context.modelData = nullptr;
+
+            // Map from flash when possible (zero-copy), SD heap copy otherwise
+            context.model = loadModelFromStorage(request.modelId, context);
             if (!context.model) throw std::runtime_error("Failed to load model file");
 
-            // Setup TFLite micro
-            context.resolver = std::make_unique<tflite::MicroMutableOpResolver<10>>();
-            setupOperators(*context.resolver);
+            // Resolver sized to this model's exact op set (ModelTraits)
+            context.resolver.reset(createResolverFor(request.modelId));
 
-            // Allocate tensor arena
-            context.tensorArenaSize = 32 * 1024; // Adjust based on model needs
-            context.tensorArena = new uint8_t[context.tensorArenaSize];
+            // Check out a right-sized arena from the shared pool, evicting
+            // LRU warm-cache models if the budget or pool demands it
+            context.tensorArenaSize = arenaSizeForModel(context.model);
+            while (residentArenaBytes() + context.tensorArenaSize > WARM_CACHE_BUDGET) {
+                if (evictLRUModel() == 0) break;
+            }
+            context.tensorArena = arenaPool.checkout(context.tensorArenaSize);
+            if (!context.tensorArena && evictLRUModel() > 0) {
+                context.tensorArena = arenaPool.checkout(context.tensorArenaSize);
+            }
+            if (!context.tensorArena) {
+                releaseModelStorage(context);
+                throw std::runtime_error("Arena pool exhausted");
+            }
 
-            // Create interpreter
+            // Create interpreter with the per-op yield hook attached
+            context.yieldHook.runtime = this;
+            context.yieldHook.owner = handle;
             context.interpreter = std::make_unique<tflite::MicroInterpreter>(
                 context.model, *context.resolver,
-                context.tensorArena, context.tensorArenaSize
+                context.tensorArena, context.tensorArenaSize,
+                nullptr, &context.yieldHook
             );
 
             if (context.interpreter->AllocateTensors() != kTfLiteOk) {
+                arenaPool.checkin(context.tensorArena);
+                releaseModelStorage(context);
                 throw std::runtime_error("Failed to allocate tensors");
             }
 
             context.state = ModelState::READY;
-            loadedModels[request.modelId] = std::move(context);
+            strncpy(models[handle].id, request.modelId, MODEL_ID_MAX - 1);
+            models[handle].id[MODEL_ID_MAX - 1] = '\0';
+            models[handle].used = true;
+            models[handle].lastUsed = ++useClock;
 
             response = {
                 .success = true,
@@ -184,23 +684,43 @@ private:
                 .outputData = nullptr,
                 .outputLength = 0,
                 .requestId = request.requestId,
-                .state = ModelState::READY
+                .state = ModelState::READY,
+                .modelHandle = handle
             };
         } catch (const std::exception& e) {
             response = {
                 .success = false,
-                .message = e.what(),
+                .message = stashError(e.what()),
                 .outputData = nullptr,
                 .outputLength = 0,
                 .requestId = request.requestId,
-                .state = ModelState::ERROR
+                .state = ModelState::ERROR,
+                .modelHandle = INVALID_MODEL
             };
         }
     }
 
-    void handleInference(const ModelRequest& request, ModelResponse& response) {
-        auto modelIt = loadedModels.find(request.modelId);
-        if (modelIt == loadedModels.end()) {
+    // Returns true when the request was offloaded to a peer and no local
+    // response must be sent (the result arrives via injectResponse later)
+    bool handleInference(const ModelRequest& request, ModelResponse& response) {
+        TRACE_RECORD_US(TRACE_MODEL_QUEUE_WAIT, request.traceUs);
+        ModelContext* contextPtr = contextFor(request);
+
+        // Offload candidates: model not here, or the scheduler is backed
+        // up and a capable peer could answer sooner
+        if (offloadHandler != nullptr &&
+            (contextPtr == nullptr || pendingCount >= OFFLOAD_DEPTH_THRESHOLD)) {
+            const char* id = request.modelId[0] == '\0'
+                                 ? idForHandle(request.modelHandle)
+                                 : request.modelId;
+            if (id != nullptr &&
+                offloadHandler(id, request.inputData, request.inputLength,
+                               request.requestId, offloadArg)) {
+                return true;
+            }
+        }
+
+        if (contextPtr == nullptr) {
             response = {
                 .success = false,
                 .message = "Model not loaded",
@@ -209,25 +729,32 @@ private:
                 .requestId = request.requestId,
                 .state = ModelState::UNLOADED
             };
-            return;
+            return false;
         }
 
         try {
-            auto& context = modelIt->second;
+            auto& context = *contextPtr;
             context.state = ModelState::RUNNING;
 
             // Copy input data to input tensor
             auto* inputTensor = context.interpreter->input(0);
+            TRACE_MARK(copyStart);
             memcpy(inputTensor->data.raw, request.inputData, request.inputLength);
+            TRACE_RECORD(TRACE_MODEL_INPUT_COPY, copyStart);
 
             // Run inference
+            TRACE_MARK(invokeStart);
             if (context.interpreter->Invoke() != kTfLiteOk) {
                 throw std::runtime_error("Inference failed");
             }
+            TRACE_RECORD(TRACE_MODEL_INVOKE, invokeStart);
 
-            // Get output
+            // Get output into a pooled buffer
             auto* outputTensor = context.interpreter->output(0);
-            uint8_t* outputData = new uint8_t[outputTensor->bytes];
+            uint8_t* outputData = BufferPool::getInstance().alloc(outputTensor->bytes);
+            if (outputData == nullptr) {
+                throw std::runtime_error("Buffer pool exhausted");
+            }
             memcpy(outputData, outputTensor->data.raw, outputTensor->bytes);
 
             context.state = ModelState::READY;
@@ -240,30 +767,217 @@ private:
                 .state = ModelState::READY
             };
         } catch (const std::exception& e) {
+            // Back to READY: a failed Invoke must not leave the slot
+            // marked RUNNING, or the LRU evictor skips it forever
+            contextPtr->state = ModelState::READY;
             response = {
                 .success = false,
-                .message = e.what(),
+                .message = stashError(e.what()),
                 .outputData = nullptr,
                 .outputLength = 0,
                 .requestId = request.requestId,
                 .state = ModelState::ERROR
             };
         }
+        return false;
+    }
+
+    // Run a whole batch inside one wakeup: one queue receive, one mutex take.
+    // The next frame is staged into the input tensor before the previous
+    // frame's response is enqueued, overlapping the memcpy with the queue
+    // round-trip. All but the last response are enqueued here; the last one
+    // goes out through the normal modelTask send.
+    void handleInferenceBatch(const ModelRequest& request, ModelResponse& response) {
+        ModelContext* contextPtr = contextFor(request);
+        if (contextPtr == nullptr || request.batchCount == 0) {
+            response = {
+                .success = false,
+                .message = "Model not loaded",
+                .outputData = nullptr,
+                .outputLength = 0,
+                .requestId = request.requestId,
+                .state = ModelState::UNLOADED
+            };
+            return;
+        }
+
+        try {
+            auto& context = *contextPtr;
+            context.state = ModelState::RUNNING;
+
+            auto* inputTensor = context.interpreter->input(0);
+            auto* outputTensor = context.interpreter->output(0);
+
+            // Prime the pipeline with the first frame
+            memcpy(inputTensor->data.raw, request.inputData, request.inputLength);
+
+            for (size_t i = 0; i < request.batchCount; i++) {
+                TRACE_MARK(invokeStart);
+                if (context.interpreter->Invoke() != kTfLiteOk) {
+                    throw std::runtime_error("Inference failed");
+                }
+                TRACE_RECORD(TRACE_MODEL_INVOKE, invokeStart);
+
+                uint8_t* outputData = BufferPool::getInstance().alloc(outputTensor->bytes);
+                if (outputData == nullptr) {
+                    throw std::runtime_error("Buffer pool exhausted");
+                }
+                memcpy(outputData, outputTensor->data.raw, outputTensor->bytes);
+
+                // Stage the next input before the response enqueue blocks us
+                if (i + 1 < request.batchCount) {
+                    memcpy(inputTensor->data.raw,
+                           request.inputData + (i + 1) * request.inputLength,
+                           request.inputLength);
+                }
+
+                response = {
+                    .success = true,
+                    .message = "Inference successful",
+                    .outputData = outputData,
+                    .outputLength = outputTensor->bytes,
+                    .requestId = request.requestId,
+                    .state = ModelState::READY
+                };
+                if (i + 1 < request.batchCount) {
+                    xQueueSend(responseQueue, &response, portMAX_DELAY);
+
+                    // Let an urgent inference preempt between frames; it may
+                    // reuse this interpreter, so restage our input if so
+                    if (request.priority != RequestPriority::HIGH &&
+                        serviceHighPriority()) {
+                        memcpy(inputTensor->data.raw,
+                               request.inputData + (i + 1) * request.inputLength,
+                               request.inputLength);
+                    }
+                }
+            }
+
+            context.state = ModelState::READY;
+        } catch (const std::exception& e) {
+            // Same as handleInference: never strand the slot in RUNNING
+            contextPtr->state = ModelState::READY;
+            response = {
+                .success = false,
+                .message = stashError(e.what()),
+                .outputData = nullptr,
+                .outputLength = 0,
+                .requestId = request.requestId,
+                .state = ModelState::ERROR
+            };
+        }
+    }
+
+    void handleModelUnload(const ModelRequest& request, ModelResponse& response) {
+        int32_t handle = request.modelHandle;
+        if (handle == INVALID_MODEL && request.modelId[0] != '\0') {
+            handle = findSlot(request.modelId);
+        }
+        if (handle < 0 || handle >= (int32_t)MAX_MODELS || !models[handle].used) {
+            response = {
+                .success = false,
+                .message = "Model not loaded",
+                .outputData = nullptr,
+                .outputLength = 0,
+                .requestId = request.requestId,
+                .state = ModelState::UNLOADED
+            };
+            return;
+        }
+
+        ModelContext& context = models[handle].context;
+        context.interpreter.reset();
+        context.resolver.reset();
+        releaseModelStorage(context);
+        arenaPool.checkin(context.tensorArena);
+        context.tensorArena = nullptr;
+        context.state = ModelState::UNLOADED;
+        models[handle].used = false;
+        models[handle].id[0] = '\0';
+
+        response = {
+            .success = true,
+            .message = "Model unloaded",
+            .outputData = nullptr,
+            .outputLength = 0,
+            .requestId = request.requestId,
+            .state = ModelState::UNLOADED
+        };
     }
 
 private:
     // Helper methods
-    const tflite::Model* loadModelFromStorage(const std::string& modelId) {
-        // Implementation depends on your storage system
-        // Return nullptr if loading fails
-        return nullptr;
+    const tflite::Model* loadModelFromStorage(const char* modelId, ModelContext& context) {
+        // Preferred path: a dedicated data partition labeled with the model ID.
+        // esp_partition_mmap gives us the flatbuffer directly in XIP flash --
+        // no heap copy, no SD transaction, load completes in microseconds.
+        const esp_partition_t* partition = esp_partition_find_first(
+            ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, modelId);
+        if (partition != nullptr) {
+            const void* mapped = nullptr;
+            esp_err_t err = esp_partition_mmap(partition, 0, partition->size,
+                                               ESP_PARTITION_MMAP_DATA, &mapped,
+                                               &context.mmapHandle);
+            if (err == ESP_OK) {
+                context.mappedFromFlash = true;
+                return tflite::GetModel(mapped);
+            }
+            ESP_LOGW("ModelRuntime", "mmap of partition '%s' failed (%d), falling back to SD",
+                     modelId, err);
+        }
+
+        // Fallback path: whole-file heap copy off the SD card (slow, costs RAM)
+        char path[96];
+        snprintf(path, sizeof(path), "/sdcard/models/%s.tflite", modelId);
+        FILE* file = fopen(path, "rb");
+        if (file == nullptr) return nullptr;
+
+        fseek(file, 0, SEEK_END);
+        size_t size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+
+        uint8_t* buffer = new uint8_t[size];
+        size_t read = fread(buffer, 1, size, file);
+        fclose(file);
+
+        if (read != size) {
+            delete[] buffer;
+            return nullptr;
+        }
+
+        context.modelData = buffer;
+        return tflite::GetModel(buffer);
+    }
+
+    size_t arenaSizeForModel(const tflite::Model* model) {
+        // The conversion pipeline stamps the measured arena requirement into
+        // the flatbuffer metadata; use it when present so small models stop
+        // paying for a worst-case arena.
+        if (model->metadata() != nullptr) {
+            for (const auto* entry : *model->metadata()) {
+                if (entry->name() != nullptr &&
+                    strcmp(entry->name()->c_str(), "min_runtime_arena") == 0) {
+                    const auto* buffer = model->buffers()->Get(entry->buffer());
+                    if (buffer->data() != nullptr && buffer->data()->size() >= sizeof(uint32_t)) {
+                        uint32_t size;
+                        memcpy(&size, buffer->data()->data(), sizeof(size));
+                        return size;
+                    }
+                }
+            }
+        }
+        return 32 * 1024; // Conservative default for unannotated models
     }
 
-    void setupOperators(tflite::MicroMutableOpResolver<10>& resolver) {
-        // Add required operators for your models
-        resolver.AddFullyConnected();
-        resolver.AddConv2D();
-        resolver.AddMaxPool2D();
-        // Add more operators as needed
+    void releaseModelStorage(ModelContext& context) {
+        if (context.mappedFromFlash) {
+            esp_partition_munmap(context.mmapHandle);
+            context.mappedFromFlash = false;
+        }
+        if (context.modelData != nullptr) {
+            delete[] context.modelData;
+            context.modelData = nullptr;
+        }
     }
+
 };
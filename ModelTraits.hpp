@@ -0,0 +1,110 @@
+// ModelTraits.hpp
+#pragma once
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include <cstring>
+
+// Per-model operator resolvers, specialized at compile time. The old
+// setupOperators() registered one MicroMutableOpResolver<10> with the
+// union of every model's ops, so a two-op anomaly detector paid the RAM
+// of ten registration slots and every AllocateTensors walked past ops it
+// could never hit. Each model tag below declares its exact op set; the
+// resolver is sized to exactly that count, so nothing is looked up or
+// stored that the model cannot use.
+//
+// Adding a model: declare a tag, specialize ModelTraits with the op set
+// from `flatc`/netron output, and append a row to kResolverFactories.
+// Unknown model ids fall back to the generic union resolver.
+
+struct AnomalyDetectorModel {};   // 2-op dense autoencoder
+struct CapabilityMatcherModel {}; // Dense capability scorer (beacon path)
+struct VisionClassifierModel {};  // Small conv net, the long-Invoke model
+struct GenericModel {};           // Fallback: legacy union op set
+
+template <typename Model>
+struct ModelTraits;
+
+template <>
+struct ModelTraits<AnomalyDetectorModel> {
+    static constexpr const char* id = "anomaly_detector";
+    static constexpr size_t OP_COUNT = 2;
+    using Resolver = tflite::MicroMutableOpResolver<OP_COUNT>;
+    static void registerOps(Resolver& resolver) {
+        resolver.AddFullyConnected();
+        resolver.AddLogistic();
+    }
+};
+
+template <>
+struct ModelTraits<CapabilityMatcherModel> {
+    static constexpr const char* id = "capability_matcher";
+    static constexpr size_t OP_COUNT = 3;
+    using Resolver = tflite::MicroMutableOpResolver<OP_COUNT>;
+    static void registerOps(Resolver& resolver) {
+        resolver.AddFullyConnected();
+        resolver.AddRelu();
+        resolver.AddSoftmax();
+    }
+};
+
+template <>
+struct ModelTraits<VisionClassifierModel> {
+    static constexpr const char* id = "vision_classifier";
+    static constexpr size_t OP_COUNT = 5;
+    using Resolver = tflite::MicroMutableOpResolver<OP_COUNT>;
+    static void registerOps(Resolver& resolver) {
+        resolver.AddConv2D();
+        resolver.AddMaxPool2D();
+        resolver.AddReshape();
+        resolver.AddFullyConnected();
+        resolver.AddSoftmax();
+    }
+};
+
+template <>
+struct ModelTraits<GenericModel> {
+    static constexpr const char* id = "";
+    static constexpr size_t OP_COUNT = 3;
+    using Resolver = tflite::MicroMutableOpResolver<OP_COUNT>;
+    static void registerOps(Resolver& resolver) {
+        resolver.AddFullyConnected();
+        resolver.AddConv2D();
+        resolver.AddMaxPool2D();
+    }
+};
+
+// Type-erased construction: model ids are runtime strings, so dispatch
+// happens once at load through this table; the resolver types themselves
+// stay fully specialized.
+namespace model_traits_detail {
+
+template <typename Model>
+tflite::MicroOpResolver* makeResolver() {
+    auto* resolver = new typename ModelTraits<Model>::Resolver();
+    ModelTraits<Model>::registerOps(*resolver);
+    return resolver;
+}
+
+struct ResolverFactory {
+    const char* id;
+    tflite::MicroOpResolver* (*create)();
+};
+
+constexpr ResolverFactory kResolverFactories[] = {
+    { ModelTraits<AnomalyDetectorModel>::id, &makeResolver<AnomalyDetectorModel> },
+    { ModelTraits<CapabilityMatcherModel>::id, &makeResolver<CapabilityMatcherModel> },
+    { ModelTraits<VisionClassifierModel>::id, &makeResolver<VisionClassifierModel> },
+};
+
+} // namespace model_traits_detail
+
+// Build the smallest resolver that covers `modelId`; unknown ids get the
+// generic union resolver so side-loaded models still run
+inline tflite::MicroOpResolver* createResolverFor(const char* modelId) {
+    using namespace model_traits_detail;
+    for (const auto& factory : kResolverFactories) {
+        if (strcmp(factory.id, modelId) == 0) {
+            return factory.create();
+        }
+    }
+    return makeResolver<GenericModel>();
+}
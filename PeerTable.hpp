@@ -0,0 +1,231 @@
+// PeerTable.hpp
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Open-addressing hash table for swarm peers, keyed on the 6-byte MAC.
+// Lookup is O(1) with linear probing so it is safe to call from the
+// ESP-NOW receive path where a linear scan over a large table would cost
+// dropped frames. An intrusive LRU list (indices threaded through the
+// slots) picks the eviction victim when the table is full.
+//
+// CAPACITY is a compile-time template parameter (power of two) so small
+// nodes keep a tiny footprint while gateways can size up to 256+.
+// The Peer type must have a `uint8_t mac_address[6]` member.
+template <typename Peer, size_t CAPACITY>
+class PeerTable {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0,
+                  "CAPACITY must be a power of two");
+    static_assert(CAPACITY <= 0x7FFF, "CAPACITY exceeds index width");
+
+public:
+    PeerTable() {
+        memset(states, EMPTY, sizeof(states));
+        lruHead = lruTail = NIL;
+        count = 0;
+        tombstones = 0;
+    }
+
+    // O(1) lookup; nullptr when the MAC is not present
+    Peer* find(const uint8_t* mac) {
+        uint16_t index;
+        return probe(mac, index) ? &slots[index] : nullptr;
+    }
+
+    // Find-or-insert and mark most-recently-used. When the table is full
+    // the least-recently-used peer is evicted to make room.
+    // `inserted` reports whether this is a fresh entry (zeroed).
+    Peer* upsert(const uint8_t* mac, bool* inserted = nullptr) {
+        // Once tombstones crowd out the EMPTY slots, a miss degenerates
+        // to a full-table scan (probe only stops at EMPTY) -- the exact
+        // linear cost this table exists to avoid. Rebuild before that.
+        if (tombstones > CAPACITY / 4) {
+            rehash();
+        }
+
+        uint16_t index;
+        if (probe(mac, index)) {
+            touchIndex(index);
+            if (inserted) *inserted = false;
+            return &slots[index];
+        }
+
+        if (count == CAPACITY) {
+            evictLRU();
+        }
+
+        // Claim the first free (empty or tombstone) slot on the probe path
+        index = hash(mac);
+        while (states[index] == OCCUPIED) {
+            index = (index + 1) & (CAPACITY - 1);
+        }
+
+        if (states[index] == TOMBSTONE) tombstones--;
+        memset(&slots[index], 0, sizeof(Peer));
+        memcpy(slots[index].mac_address, mac, 6);
+        states[index] = OCCUPIED;
+        count++;
+        linkMRU(index);
+
+        if (inserted) *inserted = true;
+        return &slots[index];
+    }
+
+    // Refresh an entry's LRU position after activity
+    void touch(Peer* peer) {
+        if (peer != nullptr) {
+            touchIndex((uint16_t)(peer - slots));
+        }
+    }
+
+    // Remove a peer by MAC; leaves a tombstone so probe chains stay intact
+    bool remove(const uint8_t* mac) {
+        uint16_t index;
+        if (!probe(mac, index)) return false;
+        unlink(index);
+        states[index] = TOMBSTONE;
+        tombstones++;
+        count--;
+        return true;
+    }
+
+    size_t size() const { return count; }
+    static constexpr size_t capacity() { return CAPACITY; }
+
+    // Visit every live peer (e.g. for ranking or persistence)
+    template <typename F>
+    void forEach(F&& fn) {
+        for (size_t i = 0; i < CAPACITY; i++) {
+            if (states[i] == OCCUPIED) {
+                fn(slots[i]);
+            }
+        }
+    }
+
+private:
+    static constexpr uint16_t NIL = 0xFFFF;
+    enum SlotState : uint8_t { EMPTY = 0, OCCUPIED, TOMBSTONE };
+
+    Peer slots[CAPACITY];
+    uint8_t states[CAPACITY];
+    uint16_t lruPrev[CAPACITY];   // Toward MRU
+    uint16_t lruNext[CAPACITY];   // Toward LRU
+    uint16_t lruHead;             // Most recently used
+    uint16_t lruTail;             // Least recently used
+    size_t count;
+    size_t tombstones;            // Rehash trigger (see upsert)
+
+    // FNV-1a over the MAC, masked to the table size
+    static uint16_t hash(const uint8_t* mac) {
+        uint32_t h = 2166136261u;
+        for (int i = 0; i < 6; i++) {
+            h = (h ^ mac[i]) * 16777619u;
+        }
+        return (uint16_t)(h & (CAPACITY - 1));
+    }
+
+    // Linear probe for an occupied slot with this MAC
+    bool probe(const uint8_t* mac, uint16_t& out) {
+        uint16_t index = hash(mac);
+        for (size_t i = 0; i < CAPACITY; i++) {
+            if (states[index] == EMPTY) return false;
+            if (states[index] == OCCUPIED &&
+                memcmp(slots[index].mac_address, mac, 6) == 0) {
+                out = index;
+                return true;
+            }
+            index = (index + 1) & (CAPACITY - 1);
+        }
+        return false;
+    }
+
+    void linkMRU(uint16_t index) {
+        lruPrev[index] = NIL;
+        lruNext[index] = lruHead;
+        if (lruHead != NIL) lruPrev[lruHead] = index;
+        lruHead = index;
+        if (lruTail == NIL) lruTail = index;
+    }
+
+    void unlink(uint16_t index) {
+        if (lruPrev[index] != NIL) lruNext[lruPrev[index]] = lruNext[index];
+        else lruHead = lruNext[index];
+        if (lruNext[index] != NIL) lruPrev[lruNext[index]] = lruPrev[index];
+        else lruTail = lruPrev[index];
+    }
+
+    void touchIndex(uint16_t index) {
+        if (lruHead == index) return;
+        unlink(index);
+        linkMRU(index);
+    }
+
+    void evictLRU() {
+        uint16_t victim = lruTail;
+        if (victim == NIL) return;
+        unlink(victim);
+        states[victim] = TOMBSTONE;
+        tombstones++;
+        count--;
+    }
+
+    // In-place rebuild that turns every tombstone back into EMPTY.
+    // Entries are relocated to their ideal probe position by following
+    // displacement chains, so no second table is needed; the LRU order
+    // is carried across through an old-index -> new-index map. Scratch
+    // is static (same rationale as the checkpoint blob): the table has
+    // a single writer, and CAPACITY*5 bytes is too much stack for the
+    // beacon task.
+    void rehash() {
+        static uint8_t oldStates[CAPACITY];
+        static uint16_t map[CAPACITY];   // Old slot -> new slot
+        static uint16_t order[CAPACITY]; // LRU chain, MRU first, new indices
+
+        memcpy(oldStates, states, sizeof(states));
+        memset(states, EMPTY, sizeof(states));
+        tombstones = 0;
+
+        // Move every occupied entry to its new probe position. A chain
+        // starts at each not-yet-moved entry; when the target slot still
+        // holds an unmoved entry, that one is displaced and placed next.
+        for (uint16_t i = 0; i < CAPACITY; i++) {
+            if (oldStates[i] != OCCUPIED) continue;
+            Peer carried = slots[i];
+            uint16_t from = i;
+            oldStates[i] = EMPTY;
+            while (true) {
+                uint16_t target = hash(carried.mac_address);
+                while (states[target] == OCCUPIED) {
+                    target = (target + 1) & (CAPACITY - 1);
+                }
+                if (oldStates[target] == OCCUPIED) {
+                    Peer displaced = slots[target];
+                    slots[target] = carried;
+                    states[target] = OCCUPIED;
+                    oldStates[target] = EMPTY;
+                    map[from] = target;
+                    carried = displaced;
+                    from = target;
+                } else {
+                    slots[target] = carried;
+                    states[target] = OCCUPIED;
+                    map[from] = target;
+                    break;
+                }
+            }
+        }
+
+        // The LRU links still describe the old indices (the move above
+        // never touched them); capture the order, then relink LRU-first
+        // so the final linkMRU leaves the true MRU at the head
+        size_t n = 0;
+        for (uint16_t o = lruHead; o != NIL; o = lruNext[o]) {
+            order[n++] = map[o];
+        }
+        lruHead = lruTail = NIL;
+        while (n > 0) {
+            linkMRU(order[--n]);
+        }
+    }
+};
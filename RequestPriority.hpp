@@ -0,0 +1,10 @@
+// RequestPriority.hpp
+#pragma once
+
+// Priority levels shared by FileManager and ModelRuntime requests.
+// HIGH requests are always dispatched before NORMAL ones and may preempt
+// a long-running NORMAL operation between its chunks.
+enum class RequestPriority {
+    NORMAL = 0,
+    HIGH = 1
+};
@@ -2,15 +2,50 @@
 #pragma once
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/event_groups.h"
 #include "esp_spiffs.h"
 #include "esp_vfs.h"
 #include "esp_vfs_fat.h"
 #include "nvs_flash.h"
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "Trace.hpp"
 #include <memory>
 #include <vector>
 
+// Task placement domains. The ESP32-S3 is dual-core: ML work owns core 1
+// while I/O and radio share core 0, so inference never time-slices with SD
+// transactions. HOUSEKEEPING tasks float (no affinity).
+enum class TaskDomain {
+    IO,
+    RADIO,
+    ML,
+    HOUSEKEEPING
+};
+
+// System monitor events, posted to the default event loop the kernel
+// already creates. Subscribers (telemetry, the warm-cache evictor) react
+// when something happens instead of polling for it. The base is defined
+// once in the main translation unit; this header is included from
+// several, so defining it here would be a duplicate symbol at link time.
+ESP_EVENT_DECLARE_BASE(SYSMON_EVENT);
+enum {
+    SYSMON_HEAP_LOW,        // Free heap crossed below the low watermark
+    SYSMON_HEAP_RECOVERED,  // Back above watermark + hysteresis
+    SYSMON_ALLOC_FAILED,    // A heap_caps allocation just failed
+    SYSMON_STATS,           // Periodic snapshot; data is a SysMonStats
+};
+
+struct SysMonStats {
+    uint32_t freeHeap;
+    uint32_t minFreeHeap;
+    uint32_t largestFreeBlock;
+    int core0Load;
+    int core1Load;
+};
+
 class SystemKernel {
 public:
     static SystemKernel& getInstance() {
@@ -18,37 +53,65 @@ public:
         return instance;
     }
 
+    // Placement policy: which core a domain's tasks are pinned to
+    static constexpr BaseType_t coreForDomain(TaskDomain domain) {
+        return (domain == TaskDomain::ML) ? 1
+             : (domain == TaskDomain::HOUSEKEEPING) ? tskNO_AFFINITY
+             : 0; // IO and RADIO share core 0
+    }
+
+    // Subsystem readiness bits. Consumers block on exactly what they
+    // need (waitReady) instead of on everything: WiFi bring-up needs
+    // READY_NVS (a few ms), FileManager traffic needs READY_SD (~900 ms)
+    // -- beaconing should never wait behind an SD mount. READY_RADIO is
+    // signaled by app_main once esp_wifi/esp_now are up.
+    static constexpr EventBits_t READY_NVS    = BIT0;
+    static constexpr EventBits_t READY_SPIFFS = BIT1;
+    static constexpr EventBits_t READY_SD     = BIT2;
+    static constexpr EventBits_t READY_RADIO  = BIT3;
+    static constexpr EventBits_t READY_STORAGE = READY_SPIFFS | READY_SD;
+    static constexpr EventBits_t READY_ALL =
+        READY_NVS | READY_SPIFFS | READY_SD;
+
+    // Launch the init stages and return; nothing here blocks on I/O.
+    // The dependency graph is shallow: the default event loop and the
+    // monitor come up inline (microseconds, and everything else posts
+    // through them), then two parallel stage tasks cover the slow parts.
+    // NVS and SPIFFS share the internal flash -- running them in
+    // separate tasks would just serialize on the flash cache -- so they
+    // form one stage on the ML core, ordered NVS-first because WiFi
+    // bring-up waits on that bit. The SD mount, ~900 ms of mostly
+    // blocked SPI waiting, gets its own task on the IO core. Stage
+    // completion is published through the readiness bits; a stage that
+    // fails logs and leaves its bit clear, so consumers see the outage
+    // as a waitReady timeout instead of a half-mounted filesystem.
     bool init() {
         ESP_LOGI(TAG, "Initializing system kernel...");
-        
-        // Initialize NVS
-        esp_err_t ret = nvs_flash_init();
-        if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-            ESP_ERROR_CHECK(nvs_flash_erase());
-            ret = nvs_flash_init();
-        }
-        ESP_ERROR_CHECK(ret);
 
-        // Initialize event loop
-        ESP_ERROR_CHECK(esp_event_loop_create_default());
+        readyEvents = xEventGroupCreate();
 
-        // Mount SPIFFS
-        if (!initSPIFFS()) {
-            ESP_LOGE(TAG, "SPIFFS mount failed");
-            return false;
-        }
+        ESP_ERROR_CHECK(esp_event_loop_create_default());
+        initMonitor();
 
-        // Mount SD Card
-        if (!initSDCard()) {
-            ESP_LOGE(TAG, "SD Card mount failed");
-            return false;
-        }
+        xTaskCreatePinnedToCore(flashStageTask, "init_flash", 4096, this, 6,
+                                nullptr, coreForDomain(TaskDomain::ML));
+        xTaskCreatePinnedToCore(sdStageTask, "init_sd", 4096, this, 6,
+                                nullptr, coreForDomain(TaskDomain::IO));
+        return true;
+    }
 
-        // Initialize task scheduler
-        initTaskScheduler();
+    // Block until every requested subsystem is up (bits stay set; any
+    // number of tasks can wait on any combination)
+    bool waitReady(EventBits_t bits, TickType_t timeout = portMAX_DELAY) {
+        EventBits_t set = xEventGroupWaitBits(readyEvents, bits,
+                                              pdFALSE, pdTRUE, timeout);
+        return (set & bits) == bits;
+    }
 
-        ESP_LOGI(TAG, "System kernel initialized successfully");
-        return true;
+    // Mark a subsystem up; used by the stage tasks and by app_main for
+    // the radio, whose bring-up lives outside the kernel
+    void signalReady(EventBits_t bits) {
+        xEventGroupSetBits(readyEvents, bits);
     }
 
     // File system paths
@@ -57,20 +120,23 @@ public:
     static constexpr const char* MODEL_PATH = "/sdcard/models";
     static constexpr const char* DATA_PATH = "/sdcard/data";
 
-    // Task management
-    TaskHandle_t createTask(TaskFunction_t task, const char* name, 
-                          uint32_t stackSize, void* params, 
-                          UBaseType_t priority) {
+    // Task management: every kernel task declares its domain and is pinned
+    // to that domain's core per the placement policy
+    TaskHandle_t createTask(TaskFunction_t task, const char* name,
+                          uint32_t stackSize, void* params,
+                          UBaseType_t priority,
+                          TaskDomain domain = TaskDomain::HOUSEKEEPING) {
         TaskHandle_t handle;
-        BaseType_t result = xTaskCreate(
+        BaseType_t result = xTaskCreatePinnedToCore(
             task,
             name,
             stackSize,
             params,
             priority,
-            &handle
+            &handle,
+            coreForDomain(domain)
         );
-        
+
         if (result == pdPASS) {
             taskHandles.push_back(handle);
             return handle;
@@ -78,6 +144,28 @@ public:
         return nullptr;
     }
 
+    // Per-core load in percent (0-100) since the previous query, computed
+    // from the idle task's share of the run-time stats counter
+    int getCoreLoad(BaseType_t core) {
+        if (core < 0 || core >= portNUM_PROCESSORS) return -1;
+
+        TaskHandle_t idle = xTaskGetIdleTaskHandleForCPU(core);
+        uint32_t idleNow = ulTaskGetRunTimeCounter(idle);
+        uint32_t totalNow = portGET_RUN_TIME_COUNTER_VALUE();
+
+        uint32_t idleDelta = idleNow - lastIdleRunTime[core];
+        uint32_t totalDelta = totalNow - lastTotalRunTime[core];
+        lastIdleRunTime[core] = idleNow;
+        lastTotalRunTime[core] = totalNow;
+
+        if (totalDelta == 0) return 0;
+        // The stats counter is a shared wall-clock timestamp, so the
+        // elapsed delta already is one core's time base; the idle task's
+        // share of it is the idle fraction directly
+        if (idleDelta >= totalDelta) return 0;
+        return (int)(100 - (idleDelta * 100) / totalDelta);
+    }
+
     void suspendTask(TaskHandle_t handle) {
         vTaskSuspend(handle);
     }
@@ -86,12 +174,89 @@ public:
         vTaskResume(handle);
     }
 
+    // Memory pressure: subsystems holding reclaimable RAM (e.g. the model
+    // warm cache) register a handler; the monitor calls them the moment
+    // the heap crosses its low watermark or an allocation fails. A
+    // handler returns how many bytes it freed.
+    using MemoryPressureHandler = size_t (*)(size_t bytesNeeded, void* arg);
+
+    bool registerMemoryPressureHandler(MemoryPressureHandler handler, void* arg) {
+        for (size_t i = 0; i < MAX_PRESSURE_HANDLERS; i++) {
+            if (pressureHandlers[i].handler == nullptr) {
+                pressureHandlers[i] = { handler, arg };
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Ask registered handlers to give memory back; stops once enough is freed
+    size_t raiseMemoryPressure(size_t bytesNeeded) {
+        size_t freed = 0;
+        for (size_t i = 0; i < MAX_PRESSURE_HANDLERS && freed < bytesNeeded; i++) {
+            if (pressureHandlers[i].handler != nullptr) {
+                freed += pressureHandlers[i].handler(bytesNeeded - freed,
+                                                     pressureHandlers[i].arg);
+            }
+        }
+        return freed;
+    }
+
 private:
     static constexpr const char* TAG = "SystemKernel";
     std::vector<TaskHandle_t> taskHandles;
+    uint32_t lastIdleRunTime[portNUM_PROCESSORS] = {};
+    uint32_t lastTotalRunTime[portNUM_PROCESSORS] = {};
+
+    static constexpr size_t MAX_PRESSURE_HANDLERS = 4;
+    struct PressureEntry {
+        MemoryPressureHandler handler;
+        void* arg;
+    };
+    PressureEntry pressureHandlers[MAX_PRESSURE_HANDLERS] = {};
 
     SystemKernel() {} // Private constructor for singleton
 
+    EventGroupHandle_t readyEvents = nullptr;
+
+    // Internal-flash stage: NVS then SPIFFS (same flash, so one task)
+    static void flashStageTask(void* arg) {
+        SystemKernel& kernel = *static_cast<SystemKernel*>(arg);
+
+        esp_err_t ret = nvs_flash_init();
+        if (ret == ESP_ERR_NVS_NO_FREE_PAGES ||
+            ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+            ESP_ERROR_CHECK(nvs_flash_erase());
+            ret = nvs_flash_init();
+        }
+        if (ret == ESP_OK) {
+            kernel.signalReady(READY_NVS);
+        } else {
+            ESP_LOGE(TAG, "NVS init failed (%d)", ret);
+        }
+
+        if (kernel.initSPIFFS()) {
+            kernel.signalReady(READY_SPIFFS);
+        } else {
+            ESP_LOGE(TAG, "SPIFFS mount failed");
+        }
+
+        vTaskDelete(nullptr);
+    }
+
+    // External-storage stage: the slow SPI-bound SD mount
+    static void sdStageTask(void* arg) {
+        SystemKernel& kernel = *static_cast<SystemKernel*>(arg);
+
+        if (kernel.initSDCard()) {
+            kernel.signalReady(READY_SD);
+        } else {
+            ESP_LOGE(TAG, "SD Card mount failed");
+        }
+
+        vTaskDelete(nullptr);
+    }
+
     bool initSPIFFS() {
         esp_vfs_spiffs_conf_t conf = {
             .base_path = SPIFFS_BASE_PATH,
@@ -133,14 +298,17 @@ private:
         
         ESP_LOGI(TAG, "Initializing SD card");
 
-        // Initialize SPI bus for SD card
+        // Initialize SPI bus for SD card. max_transfer_sz is the DMA limit:
+        // 4000 forced everything through small CPU-copied transactions, so
+        // raise it to the descriptor chain maximum and let FileManager's
+        // aligned buffers ride DMA end-to-end.
         spi_bus_config_t bus_cfg = {
             .mosi_io_num = CONFIG_SD_MOSI,
             .miso_io_num = CONFIG_SD_MISO,
             .sclk_io_num = CONFIG_SD_SCK,
             .quadwp_io_num = -1,
             .quadhd_io_num = -1,
-            .max_transfer_sz = 4000,
+            .max_transfer_sz = 32 * 1024,
         };
 
         sdmmc_host_t host = SDSPI_HOST_DEFAULT();
@@ -165,41 +333,132 @@ private:
         return true;
     }
 
-    void initTaskScheduler() {
-        // Initialize system monitoring task
-        createTask(systemMonitorTask, "SysMonitor", 2048, nullptr, 1);
-        
-        // Initialize memory management task
-        createTask(memoryManagerTask, "MemManager", 2048, nullptr, 2);
-    }
-
-    static void systemMonitorTask(void* parameters) {
-        while(1) {
-            // Monitor system health
-            ESP_LOGI(TAG, "Free heap: %lu", esp_get_free_heap_size());
-            ESP_LOGI(TAG, "Min free heap: %lu", esp_get_minimum_free_heap_size());
-            
-            // Check task states
-            char* taskList = (char*)malloc(2048);
-            if (taskList) {
-                vTaskList(taskList);
-                ESP_LOGI(TAG, "Task List:\n%s", taskList);
-                free(taskList);
-            }
-            
-            vTaskDelay(pdMS_TO_TICKS(10000)); // 10 second intervals
+    // --- Event-driven system monitor ---------------------------------
+    // Replaces the old SysMonitor/MemManager polling tasks (two always-on
+    // tasks, a malloc'd vTaskList dump every 10 s, and a 5 s blind spot
+    // on low memory). Now:
+    //   - a failed heap_caps allocation fires allocFailedHook immediately
+    //   - a cheap 250 ms esp_timer reads one heap counter and posts
+    //     SYSMON_HEAP_LOW on a watermark crossing (the IDF heap has no
+    //     threshold callback, so this is the closest thing to one; the
+    //     check is a single register-width read, not a task wakeup)
+    //   - stats snapshots go out as SYSMON_STATS events every 10 s from
+    //     a preallocated buffer; the kernel's own subscriber logs them
+    // Pressure handlers are driven from the crossing itself, so the
+    // warm-cache evictor reacts in milliseconds, not at the next poll.
+
+    static constexpr size_t HEAP_LOW_WATERMARK = 16 * 1024;
+    static constexpr size_t HEAP_HYSTERESIS = 4 * 1024;
+    static constexpr uint64_t WATERMARK_PERIOD_US = 250 * 1000;
+    static constexpr uint64_t STATS_PERIOD_US = 10 * 1000 * 1000;
+
+    void initMonitor() {
+        taskDumpBuffer = (char*)malloc(TASK_DUMP_SIZE); // Once, at boot
+
+        heap_caps_register_failed_alloc_callback(&allocFailedHook);
+
+        esp_event_handler_register(SYSMON_EVENT, SYSMON_STATS,
+                                   &logStatsHandler, nullptr);
+        esp_event_handler_register(SYSMON_EVENT, SYSMON_HEAP_LOW,
+                                   &heapLowHandler, nullptr);
+
+        const esp_timer_create_args_t watermarkArgs = {
+            .callback = [](void*) { getInstance().checkWatermarks(); },
+            .arg = nullptr,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "sysmon_wm"
+        };
+        esp_timer_create(&watermarkArgs, &watermarkTimer);
+        esp_timer_start_periodic(watermarkTimer, WATERMARK_PERIOD_US);
+
+        const esp_timer_create_args_t statsArgs = {
+            .callback = [](void*) { getInstance().publishStats(); },
+            .arg = nullptr,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "sysmon_stats"
+        };
+        esp_timer_create(&statsArgs, &statsTimer);
+        esp_timer_start_periodic(statsTimer, STATS_PERIOD_US);
+    }
+
+    void checkWatermarks() {
+        size_t freeHeap = esp_get_free_heap_size();
+        if (!heapLow && freeHeap < HEAP_LOW_WATERMARK) {
+            heapLow = true;
+            // Reclaim inline before the event even dispatches; the
+            // subscribers handle diagnostics, not survival
+            size_t freed = raiseMemoryPressure(HEAP_LOW_WATERMARK - freeHeap
+                                               + HEAP_HYSTERESIS);
+            ESP_LOGW(TAG, "Heap low (%u free), pressure freed %u",
+                     (unsigned)freeHeap, (unsigned)freed);
+            esp_event_post(SYSMON_EVENT, SYSMON_HEAP_LOW,
+                           &freeHeap, sizeof(freeHeap), 0);
+        } else if (heapLow && freeHeap > HEAP_LOW_WATERMARK + HEAP_HYSTERESIS) {
+            heapLow = false;
+            esp_event_post(SYSMON_EVENT, SYSMON_HEAP_RECOVERED,
+                           &freeHeap, sizeof(freeHeap), 0);
         }
     }
 
-    static void memoryManagerTask(void* parameters) {
-        while(1) {
-            // Monitor heap fragmentation
-            if (esp_get_free_heap_size() < 10000) {  // Example threshold
-                ESP_LOGW(TAG, "Low memory condition detected");
-                // Trigger cleanup routines
+    void publishStats() {
+        stats.freeHeap = esp_get_free_heap_size();
+        stats.minFreeHeap = esp_get_minimum_free_heap_size();
+        stats.largestFreeBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+        stats.core0Load = getCoreLoad(0);
+        stats.core1Load = getCoreLoad(1);
+        esp_event_post(SYSMON_EVENT, SYSMON_STATS, &stats, sizeof(stats), 0);
+    }
+
+    static void allocFailedHook(size_t size, uint32_t caps,
+                                const char* functionName) {
+        ESP_LOGE(TAG, "Alloc of %u bytes (caps 0x%lx) failed in %s",
+                 (unsigned)size, (unsigned long)caps, functionName);
+        getInstance().raiseMemoryPressure(size);
+        esp_event_post(SYSMON_EVENT, SYSMON_ALLOC_FAILED,
+                       &size, sizeof(size), 0);
+    }
+
+    static void logStatsHandler(void* arg, esp_event_base_t base,
+                                int32_t id, void* data) {
+        SysMonStats* s = (SysMonStats*)data;
+        ESP_LOGI(TAG, "heap free=%lu min=%lu largest=%lu load0=%d%% load1=%d%%",
+                 (unsigned long)s->freeHeap, (unsigned long)s->minFreeHeap,
+                 (unsigned long)s->largestFreeBlock,
+                 s->core0Load, s->core1Load);
+
+#if SWARM_TRACE_ENABLED
+        // Hot-path stage latencies from the trace rings; a regression
+        // in queue wait or Invoke shows up here, not on a scope
+        uint32_t cyclesPerUs = ets_get_cpu_frequency();
+        for (int stage = 0; stage < TRACE_STAGE_COUNT; stage++) {
+            uint32_t p50, p99, count;
+            if (Trace::getInstance().percentiles((TraceStage)stage,
+                                                 p50, p99, count)) {
+                ESP_LOGI(TAG, "trace %-16s p50=%luus p99=%luus n=%lu",
+                         Trace::stageName((TraceStage)stage),
+                         (unsigned long)(p50 / cyclesPerUs),
+                         (unsigned long)(p99 / cyclesPerUs),
+                         (unsigned long)count);
             }
-            
-            vTaskDelay(pdMS_TO_TICKS(5000)); // 5 second intervals
         }
+#endif
     }
+
+    static void heapLowHandler(void* arg, esp_event_base_t base,
+                               int32_t id, void* data) {
+        // Task dump only when something is actually wrong, into the
+        // buffer preallocated at boot -- no heap churn on a sick heap
+        SystemKernel& kernel = getInstance();
+        if (kernel.taskDumpBuffer != nullptr) {
+            vTaskList(kernel.taskDumpBuffer);
+            ESP_LOGW(TAG, "Task list at heap-low:\n%s", kernel.taskDumpBuffer);
+        }
+    }
+
+    static constexpr size_t TASK_DUMP_SIZE = 2048;
+    char* taskDumpBuffer = nullptr;
+    bool heapLow = false;
+    SysMonStats stats = {};
+    esp_timer_handle_t watermarkTimer = nullptr;
+    esp_timer_handle_t statsTimer = nullptr;
 };
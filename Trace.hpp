@@ -0,0 +1,140 @@
+// Trace.hpp
+#pragma once
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include <cstdint>
+#include <cstring>
+
+// Cycle-accurate stage tracing for the request hot paths. A request that
+// takes 40 ms end-to-end is opaque without this: queue wait, mutex wait,
+// tensor copy, Invoke and response enqueue all hide inside one number.
+// Each instrumented span records its cycle delta into a fixed per-stage
+// ring; the kernel's stats reporter queries p50/p99 from the rings, so
+// regressions show up on the serial console instead of a logic analyzer.
+//
+// Build with -DSWARM_TRACE_ENABLED=0 to compile every probe out; the
+// TRACE_* macros expand to nothing and the rings are never linked in.
+//
+// Cycle counts come from esp_cpu_get_cycle_count() and are only valid
+// within one task: the app core's CCOUNT starts when the bootloader
+// releases it, hundreds of milliseconds after the PRO core's, so the
+// counters carry a huge constant offset. Spans that cross a queue (and
+// therefore possibly a core -- producers run on core 0, the model task
+// on core 1) use the _US variants below, which stamp the shared
+// esp_timer wall clock instead and record the delta converted to
+// cycles, keeping the rings in one unit.
+
+#ifndef SWARM_TRACE_ENABLED
+#define SWARM_TRACE_ENABLED 1
+#endif
+
+enum TraceStage {
+    TRACE_FILE_QUEUE_WAIT,      // requestX() enqueue -> fileTask dequeue
+    TRACE_FILE_HANDLER,         // SD work under fileMutex
+    TRACE_MODEL_QUEUE_WAIT,     // requestInference() -> execution starts
+    TRACE_MODEL_MUTEX_WAIT,     // dispatch() blocked on modelMutex
+    TRACE_MODEL_INPUT_COPY,     // Input tensor memcpy
+    TRACE_MODEL_INVOKE,         // interpreter->Invoke()
+    TRACE_MODEL_RESPONSE,       // Response xQueueSend
+    TRACE_STAGE_COUNT
+};
+
+#if SWARM_TRACE_ENABLED
+
+class Trace {
+public:
+    static constexpr size_t RING_SIZE = 64; // Samples kept per stage
+
+    static Trace& getInstance() {
+        static Trace instance;
+        return instance;
+    }
+
+    void record(TraceStage stage, uint32_t cycles) {
+        taskENTER_CRITICAL(&traceLock);
+        Ring& ring = rings[stage];
+        ring.samples[ring.head % RING_SIZE] = cycles;
+        ring.head++;
+        taskEXIT_CRITICAL(&traceLock);
+    }
+
+    // p50/p99 over the stage's ring, in cycles. Returns false when no
+    // samples exist. Copies the ring out under the lock and sorts the
+    // copy, so the hot path never pays for the query.
+    bool percentiles(TraceStage stage, uint32_t& p50, uint32_t& p99,
+                     uint32_t& count) {
+        uint32_t local[RING_SIZE];
+        size_t n;
+
+        taskENTER_CRITICAL(&traceLock);
+        Ring& ring = rings[stage];
+        n = (ring.head < RING_SIZE) ? ring.head : RING_SIZE;
+        memcpy(local, ring.samples, n * sizeof(uint32_t));
+        count = ring.head;
+        taskEXIT_CRITICAL(&traceLock);
+
+        if (n == 0) return false;
+
+        // Insertion sort: n <= 64 and this runs once per report interval
+        for (size_t i = 1; i < n; i++) {
+            uint32_t v = local[i];
+            size_t j = i;
+            while (j > 0 && local[j - 1] > v) {
+                local[j] = local[j - 1];
+                j--;
+            }
+            local[j] = v;
+        }
+
+        p50 = local[n / 2];
+        p99 = local[(n * 99) / 100];
+        return true;
+    }
+
+    static const char* stageName(TraceStage stage) {
+        static const char* names[TRACE_STAGE_COUNT] = {
+            "file.queue_wait", "file.handler",
+            "model.queue_wait", "model.mutex_wait",
+            "model.input_copy", "model.invoke", "model.response",
+        };
+        return names[stage];
+    }
+
+private:
+    struct Ring {
+        uint32_t samples[RING_SIZE];
+        uint32_t head;
+    };
+    Ring rings[TRACE_STAGE_COUNT] = {};
+    portMUX_TYPE traceLock = portMUX_INITIALIZER_UNLOCKED;
+
+    Trace() {}
+};
+
+// Stamp a point in time; pairs with TRACE_RECORD to log the span.
+// Same-task only (CCOUNT is per-core).
+#define TRACE_MARK(name) uint32_t name = esp_cpu_get_cycle_count()
+// Record the cycles elapsed since `mark` against `stage`
+#define TRACE_RECORD(stage, mark) \
+    Trace::getInstance().record((stage), esp_cpu_get_cycle_count() - (mark))
+
+// Wall-clock variants for spans that travel through a queue to another
+// task. Truncation to 32 bits is fine: deltas are computed mod 2^32, so
+// they stay correct across the ~71-minute wrap for any realistic span.
+#define TRACE_STAMP_US(field) (field) = (uint32_t)esp_timer_get_time()
+// Records in cycles (delta-us times the CPU frequency in MHz) so every
+// ring keeps one unit; microsecond resolution is plenty for queue waits
+#define TRACE_RECORD_US(stage, mark) \
+    Trace::getInstance().record((stage), \
+        ((uint32_t)esp_timer_get_time() - (mark)) * ets_get_cpu_frequency())
+
+#else // !SWARM_TRACE_ENABLED
+
+#define TRACE_MARK(name) do {} while (0)
+#define TRACE_RECORD(stage, mark) do {} while (0)
+#define TRACE_STAMP_US(field) do {} while (0)
+#define TRACE_RECORD_US(stage, mark) do {} while (0)
+
+#endif // SWARM_TRACE_ENABLED
@@ -3,41 +3,703 @@
 #include <esp_now.h>
 #include <esp_wifi.h>
 #include <nvs_flash.h>
+#include <nvs.h>
 #include <tensorflow/lite/micro/micro_interpreter.h>
 #include <tensorflow/lite/micro/micro_resolver.h>
 #include <tensorflow/lite/schema/schema_generated.h>
 #include <esp_log.h>
+#include "PeerTable.hpp"
+#include "BufferPool.hpp"
+#include "ModelRuntime.hpp"
+#include "BulkTransfer.hpp"
+
+// One definition of the system monitor event base declared in
+// SystemKernel.hpp
+ESP_EVENT_DEFINE_BASE(SYSMON_EVENT);
 
 // Swarm Intelligence Configuration
 #define NODE_ID_LENGTH 6
-#define MAX_PEERS 20
+#define PEER_TABLE_CAPACITY 32  // Power of two; gateways build with 256+
 #define BEACON_INTERVAL_MS 5000
+
+// Adaptive beaconing: the interval starts at BEACON_INTERVAL_MS and backs
+// off exponentially while the swarm is quiet -- no new peers, no CRC
+// mismatches, sends going out clean. Any churn event or a send-failure
+// rate above the threshold snaps it back to the minimum so topology
+// changes are tracked quickly. Dense clusters (everyone hears everyone)
+// are allowed to back off further than sparse ones, where a node still
+// looking for peers keeps a tighter ceiling.
+#define BEACON_INTERVAL_MIN_MS 1000
+#define BEACON_INTERVAL_MAX_MS 30000
+#define BEACON_SPARSE_MAX_MS 10000
+#define BEACON_DENSE_PEER_COUNT 8
+#define BEACON_FAIL_RATE_PCT 20
+
+// Peer-table persistence: the table is checkpointed to NVS so a reboot
+// (OTA, brownout, watchdog) does not mean rediscovering the swarm from
+// scratch. Restored entries are tentative -- usable for routing right
+// away, but dropped if the peer's first beacon or heartbeat has not
+// confirmed them by the end of the confirmation window.
+#define PEER_SNAPSHOT_NAMESPACE "swarm"
+#define PEER_SNAPSHOT_KEY "peers"
+#define PEER_SNAPSHOT_VERSION 2  // v2: 16-bit peer count (gateways hold 256+)
+#define PEER_SNAPSHOT_MIN_MS 60000      // Min spacing between NVS writes
+#define PEER_TENTATIVE_WINDOW_MS 60000  // Confirm-or-drop deadline
 #define AI_MODEL_INPUT_SIZE 64
 #define AI_MODEL_OUTPUT_SIZE 32
 #define TAG "SwarmNode"
 
-// Peer Discovery and Management
+// Delta-beacon protocol: a full capability vector goes on air only when it
+// has drifted past this threshold since the last full beacon; otherwise a
+// compact heartbeat (id + sequence + crc) keeps the peer entry alive.
+// Receivers that see a crc they don't recognize ask for a full sync.
+// Capabilities are int8 end-to-end (the model is int8-quantized), so the
+// threshold is in quantized steps: 4/127 ~= 3% of full scale.
+#define CAPABILITY_DELTA_THRESHOLD 4
+#define BEACON_TYPE_FULL      0x01
+#define BEACON_TYPE_HEARTBEAT 0x02
+#define BEACON_TYPE_SYNC_REQ  0x03
+#define BEACON_TYPE_OFFLOAD_REQ  0x04
+#define BEACON_TYPE_OFFLOAD_RESP 0x05
+
+// Inference offload: input tensors ship to a capable peer in MTU-sized
+// chunks; the result streams back the same way and is surfaced through
+// the requester's normal ModelResponse queue.
+#define OFFLOAD_CHUNK_PAYLOAD 200
+#define OFFLOAD_MAX_TENSOR 1024
+#define OFFLOAD_MAX_OUTPUT 256
+#define MAX_OFFLOAD_JOBS 4
+#define OFFLOAD_MODEL_ID_LEN 16
+#define OFFLOAD_TIMEOUT_MS 2000
+
+typedef struct {
+    uint8_t type;              // BEACON_TYPE_OFFLOAD_REQ
+    uint8_t sender_id[NODE_ID_LENGTH];
+    uint32_t job_id;
+    char model_id[OFFLOAD_MODEL_ID_LEN];
+    uint16_t total_len;
+    uint16_t offset;
+    uint8_t chunk_len;
+    uint8_t payload[OFFLOAD_CHUNK_PAYLOAD];
+} OffloadRequestPacket;
+
+typedef struct {
+    uint8_t type;              // BEACON_TYPE_OFFLOAD_RESP
+    uint8_t sender_id[NODE_ID_LENGTH];
+    uint32_t job_id;
+    uint8_t success;
+    uint16_t total_len;
+    uint16_t offset;
+    uint8_t chunk_len;
+    uint8_t payload[OFFLOAD_CHUNK_PAYLOAD];
+} OffloadResponsePacket;
+
+// CRC-16 of a model ID string; maps a model onto its capability dimension
+static uint16_t str_crc16(const char* s) {
+    uint16_t crc = 0xFFFF;
+    while (*s) {
+        crc ^= (uint16_t)(uint8_t)(*s++) << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Receive ring between the ESP-NOW callback (WiFi task) and the beacon
+// processing task. Power of two so index wrap is a mask.
+#define RX_RING_SIZE 32
+#define RX_FRAME_MAX 250  // ESP-NOW payload limit
+
+typedef struct {
+    uint8_t len;
+    uint8_t src_mac[6];        // Radio-level sender, from the rx metadata
+    int8_t rssi;               // As measured by the PHY for this frame
+    uint8_t data[RX_FRAME_MAX];
+} RxFrame;
+
+// Send outcomes cross from the ESP-NOW send callback (WiFi task) to the
+// beacon task through their own small SPSC ring, same discipline as the
+// receive ring: the callback only copies and returns.
+#define TX_RING_SIZE 16
+
+typedef struct {
+    uint8_t mac[6];
+    uint8_t ok;
+} TxEvent;
+
+// Capability matching: per-dimension top-k lists, maintained incrementally
+// as beacons arrive. Re-ranking the whole table per query would cost
+// O(peers * dims); the amortized per-beacon update is O(dims * k).
+#define MATCH_TOP_K 4
+
 typedef struct {
     uint8_t mac_address[6];
-    int8_t rssi;
+    int8_t score;
+    bool valid;
+} TopKEntry;
+
+// Peer Discovery and Management. Capabilities stay in the model's int8
+// quantized domain: 32 bytes per peer and per beacon instead of 128, and
+// the similarity kernel works on 4x denser data per load.
+typedef struct {
+    uint8_t mac_address[6];
+    int8_t rssi;               // Most recent frame
+    int8_t rssi_ewma;          // EWMA (alpha 1/8); 0 until the first frame
+    uint8_t delivery_q8;       // Unicast delivery success, Q8 (255 = 100%)
     uint32_t last_seen;
     bool is_active;
-    float capabilities[AI_MODEL_OUTPUT_SIZE];
+    bool tentative;            // Restored from NVS, not yet heard on air
+    int8_t capabilities[AI_MODEL_OUTPUT_SIZE];
+    uint16_t last_sequence;
+    uint16_t capability_crc;   // CRC of the last full vector we stored
 } SwarmPeer;
 
+// On-flash peer snapshot: a version byte, a count byte, then packed
+// records. ~41 bytes per peer, so a full 32-entry table is a 1.3 KB blob
+// -- one NVS entry, rewritten at most once a minute.
+typedef struct __attribute__((packed)) {
+    uint8_t mac_address[6];
+    int8_t capabilities[AI_MODEL_OUTPUT_SIZE];
+    uint16_t capability_crc;
+    int8_t rssi_ewma;
+} PeerSnapshotRecord;
+
 typedef struct {
+    uint8_t type;              // BEACON_TYPE_FULL
     uint8_t sender_id[NODE_ID_LENGTH];
-    float capabilities[AI_MODEL_OUTPUT_SIZE];
+    uint16_t sequence;
+    int8_t capabilities[AI_MODEL_OUTPUT_SIZE];
     uint32_t timestamp;
 } BeaconPacket;
 
+typedef struct {
+    uint8_t type;              // BEACON_TYPE_HEARTBEAT
+    uint8_t sender_id[NODE_ID_LENGTH];
+    uint16_t sequence;
+    uint16_t capability_crc;   // CRC of the sender's current full vector
+    uint32_t timestamp;
+} HeartbeatPacket;
+
+typedef struct {
+    uint8_t type;              // BEACON_TYPE_SYNC_REQ
+    uint8_t sender_id[NODE_ID_LENGTH];
+    uint8_t target_id[NODE_ID_LENGTH];
+} SyncRequestPacket;
+
+// Int8 similarity kernel for peer ranking: plain dot product, manually
+// unrolled by four so the compiler can keep the accumulators in registers
+// (and lower to the S3's SIMD MACs where available).
+static int32_t capability_similarity(const int8_t* a, const int8_t* b) {
+    int32_t acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+    for (int i = 0; i < AI_MODEL_OUTPUT_SIZE; i += 4) {
+        acc0 += (int32_t)a[i]     * b[i];
+        acc1 += (int32_t)a[i + 1] * b[i + 1];
+        acc2 += (int32_t)a[i + 2] * b[i + 2];
+        acc3 += (int32_t)a[i + 3] * b[i + 3];
+    }
+    return acc0 + acc1 + acc2 + acc3;
+}
+
+// CRC-16/CCITT over the capability vector bytes
+static uint16_t capability_crc16(const int8_t* capabilities) {
+    const uint8_t* data = (const uint8_t*)capabilities;
+    size_t len = AI_MODEL_OUTPUT_SIZE * sizeof(int8_t);
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
 class SwarmIntelligenceNode {
 private:
-    SwarmPeer peers[MAX_PEERS];
+    // Hash-indexed peer table: O(1) MAC lookup in the receive path,
+    // LRU eviction of stale peers when full
+    PeerTable<SwarmPeer, PEER_TABLE_CAPACITY> peers;
     uint8_t node_id[NODE_ID_LENGTH];
     tflite::MicroInterpreter* interpreter;
     uint8_t tensor_arena[16 * 1024];  // 16KB tensor arena
 
+    // Delta-beacon state: the vector as last broadcast in full, its CRC,
+    // and whether a peer has asked us to resend the full vector
+    int8_t last_sent_capabilities[AI_MODEL_OUTPUT_SIZE];
+    uint16_t tx_sequence;
+    uint16_t last_sent_crc;
+    bool force_full_beacon;
+
+    // Adaptive beacon state. churn_events counts table inserts and CRC
+    // mismatches (bumped by the beacon task); the send counters are bumped
+    // from the ESP-NOW send callback (WiFi task). All are sampled and
+    // reset by the run loop with single 32-bit accesses, so a lost update
+    // costs at most one interval decision, never corruption.
+    uint32_t beacon_interval_ms;
+    volatile uint32_t churn_events;
+    volatile uint32_t send_attempts;
+    volatile uint32_t send_failures;
+
+    // Peer persistence state. Written only by the beacon task (the
+    // restore happens in the constructor, before that task exists).
+    bool peers_dirty;
+    int64_t last_snapshot_us;
+    int64_t tentative_deadline_us;
+    bool tentative_sweep_done;
+
+    // The ESP-NOW receive callback can't capture `this`
+    static SwarmIntelligenceNode* s_instance;
+
+    // Lock-free single-producer/single-consumer ring: the receive callback
+    // (WiFi task) only memcpys the frame in and returns, so the radio
+    // stack is never stalled by peer-table work. The beacon task drains
+    // whole batches per wakeup.
+    RxFrame rx_ring[RX_RING_SIZE];
+    volatile uint32_t rx_head;    // Written only by the receive callback
+    volatile uint32_t rx_tail;    // Written only by the beacon task
+    uint32_t rx_dropped;
+    TaskHandle_t beacon_task_handle;
+
+    // Send-outcome ring: send callback produces, beacon task consumes
+    TxEvent tx_ring[TX_RING_SIZE];
+    volatile uint32_t tx_head;
+    volatile uint32_t tx_tail;
+
+    // Top-k peers per capability dimension, sorted descending by score.
+    // Entries are validated against the peer table on read, so eviction
+    // does not need to sweep these lists.
+    TopKEntry top_peers[AI_MODEL_OUTPUT_SIZE][MATCH_TOP_K];
+
+    // Fold one freshly arrived capability vector into the top-k lists
+    void updateTopK(const uint8_t* mac, const int8_t* capabilities) {
+        for (int d = 0; d < AI_MODEL_OUTPUT_SIZE; d++) {
+            TopKEntry* list = top_peers[d];
+            int8_t score = capabilities[d];
+
+            // Drop any previous entry for this peer (its score changed)
+            for (int i = 0; i < MATCH_TOP_K; i++) {
+                if (list[i].valid &&
+                    memcmp(list[i].mac_address, mac, 6) == 0) {
+                    for (int j = i; j + 1 < MATCH_TOP_K; j++) {
+                        list[j] = list[j + 1];
+                    }
+                    list[MATCH_TOP_K - 1].valid = false;
+                    break;
+                }
+            }
+
+            // Sorted insert; k is tiny so this is a handful of compares
+            for (int i = 0; i < MATCH_TOP_K; i++) {
+                if (!list[i].valid || score > list[i].score) {
+                    for (int j = MATCH_TOP_K - 1; j > i; j--) {
+                        list[j] = list[j - 1];
+                    }
+                    memcpy(list[i].mac_address, mac, 6);
+                    list[i].score = score;
+                    list[i].valid = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    // --- Inference offload ------------------------------------------
+    ModelRuntime* runtime;
+    uint32_t next_job_id;
+
+    // --- Bulk transfer (model distribution) -------------------------
+    BulkTransfer bulk;
+    FileManager* fileManager;
+
+    struct OutboundJob {        // We asked a peer to run an inference
+        bool active;
+        uint32_t job_id;
+        uint32_t request_id;
+        int64_t deadline_us;    // Give up and fail the request past this
+        uint8_t response[OFFLOAD_MAX_OUTPUT];
+        uint16_t received;
+        uint16_t total;
+    };
+    OutboundJob outbound[MAX_OFFLOAD_JOBS];
+
+    struct InboundJob {         // A peer asked us to run an inference
+        bool active;
+        uint32_t job_id;
+        uint8_t requester[NODE_ID_LENGTH];
+        char model_id[OFFLOAD_MODEL_ID_LEN];
+        uint8_t input[OFFLOAD_MAX_TENSOR];
+        uint16_t received;
+        uint16_t total;
+    };
+    InboundJob inbound[MAX_OFFLOAD_JOBS];
+
+    // Unicast needs the peer registered with ESP-NOW first
+    void ensurePeerAdded(const uint8_t* mac) {
+        esp_now_peer_info_t info = {};
+        memcpy(info.peer_addr, mac, 6);
+        info.channel = 0;
+        info.ifidx = WIFI_IF_STA;
+        esp_err_t err = esp_now_add_peer(&info);
+        if (err != ESP_OK && err != ESP_ERR_ESPNOW_EXIST) {
+            ESP_LOGW(TAG, "esp_now_add_peer failed: %d", err);
+        }
+    }
+
+    // Requester side: ship an input tensor to the best-matching peer.
+    // Returns false if no peer or job slot is available, in which case
+    // the runtime falls back to its local error path.
+    bool offloadInference(const char* model_id, const uint8_t* input,
+                          size_t len, uint32_t request_id) {
+        if (len == 0 || len > OFFLOAD_MAX_TENSOR) return false;
+
+        // Route on the model's capability dimension (deployment
+        // convention: dimension = crc16(model id) mod vector size)
+        uint8_t target[1][6];
+        int dim = str_crc16(model_id) % AI_MODEL_OUTPUT_SIZE;
+        if (findBestPeers(dim, 1, target) < 1) return false;
+
+        OutboundJob* job = nullptr;
+        for (int i = 0; i < MAX_OFFLOAD_JOBS; i++) {
+            if (!outbound[i].active) { job = &outbound[i]; break; }
+        }
+        if (job == nullptr) return false;
+
+        job->job_id = next_job_id++;
+        job->request_id = request_id;
+        job->deadline_us = esp_timer_get_time() + OFFLOAD_TIMEOUT_MS * 1000LL;
+        job->received = 0;
+        job->total = 0;
+        job->active = true; // Last: the sweep runs on another task
+
+        ensurePeerAdded(target[0]);
+
+        OffloadRequestPacket pkt;
+        pkt.type = BEACON_TYPE_OFFLOAD_REQ;
+        memcpy(pkt.sender_id, node_id, NODE_ID_LENGTH);
+        pkt.job_id = job->job_id;
+        strncpy(pkt.model_id, model_id, OFFLOAD_MODEL_ID_LEN - 1);
+        pkt.model_id[OFFLOAD_MODEL_ID_LEN - 1] = '\0';
+
+        const size_t header = sizeof(OffloadRequestPacket) - OFFLOAD_CHUNK_PAYLOAD;
+        for (size_t off = 0; off < len; off += OFFLOAD_CHUNK_PAYLOAD) {
+            size_t chunk = len - off;
+            if (chunk > OFFLOAD_CHUNK_PAYLOAD) chunk = OFFLOAD_CHUNK_PAYLOAD;
+            pkt.total_len = (uint16_t)len;
+            pkt.offset = (uint16_t)off;
+            pkt.chunk_len = (uint8_t)chunk;
+            memcpy(pkt.payload, input + off, chunk);
+            if (esp_now_send(target[0], (uint8_t*)&pkt, header + chunk) != ESP_OK) {
+                job->active = false;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Server side: reassemble the input, run it, stream the result back
+    void processOffloadRequest(const OffloadRequestPacket& pkt) {
+        if (pkt.total_len > OFFLOAD_MAX_TENSOR ||
+            pkt.offset + pkt.chunk_len > pkt.total_len) return;
+
+        InboundJob* job = nullptr;
+        for (int i = 0; i < MAX_OFFLOAD_JOBS; i++) {
+            if (inbound[i].active && inbound[i].job_id == pkt.job_id &&
+                memcmp(inbound[i].requester, pkt.sender_id, NODE_ID_LENGTH) == 0) {
+                job = &inbound[i];
+                break;
+            }
+        }
+        if (job == nullptr) {
+            for (int i = 0; i < MAX_OFFLOAD_JOBS; i++) {
+                if (!inbound[i].active) { job = &inbound[i]; break; }
+            }
+            if (job == nullptr) return; // Busy: requester will time out
+            job->active = true;
+            job->job_id = pkt.job_id;
+            memcpy(job->requester, pkt.sender_id, NODE_ID_LENGTH);
+            memcpy(job->model_id, pkt.model_id, OFFLOAD_MODEL_ID_LEN);
+            job->model_id[OFFLOAD_MODEL_ID_LEN - 1] = '\0';
+            job->received = 0;
+            job->total = pkt.total_len;
+        }
+
+        memcpy(job->input + pkt.offset, pkt.payload, pkt.chunk_len);
+        job->received += pkt.chunk_len;
+        if (job->received < job->total) return;
+
+        uint8_t output[OFFLOAD_MAX_OUTPUT];
+        size_t out_len = 0;
+        bool ok = (runtime != nullptr) &&
+                  runtime->executeForOffload(job->model_id, job->input,
+                                             job->total, output,
+                                             sizeof(output), &out_len);
+        sendOffloadResponse(job->requester, job->job_id, ok, output, out_len);
+        job->active = false;
+    }
+
+    void sendOffloadResponse(const uint8_t* requester, uint32_t job_id,
+                             bool success, const uint8_t* data, size_t len) {
+        ensurePeerAdded(requester);
+
+        OffloadResponsePacket pkt;
+        pkt.type = BEACON_TYPE_OFFLOAD_RESP;
+        memcpy(pkt.sender_id, node_id, NODE_ID_LENGTH);
+        pkt.job_id = job_id;
+        pkt.success = success ? 1 : 0;
+
+        const size_t header = sizeof(OffloadResponsePacket) - OFFLOAD_CHUNK_PAYLOAD;
+        if (!success || len == 0) {
+            pkt.total_len = 0;
+            pkt.offset = 0;
+            pkt.chunk_len = 0;
+            esp_now_send(requester, (uint8_t*)&pkt, header);
+            return;
+        }
+        for (size_t off = 0; off < len; off += OFFLOAD_CHUNK_PAYLOAD) {
+            size_t chunk = len - off;
+            if (chunk > OFFLOAD_CHUNK_PAYLOAD) chunk = OFFLOAD_CHUNK_PAYLOAD;
+            pkt.total_len = (uint16_t)len;
+            pkt.offset = (uint16_t)off;
+            pkt.chunk_len = (uint8_t)chunk;
+            memcpy(pkt.payload, data + off, chunk);
+            esp_now_send(requester, (uint8_t*)&pkt, header + chunk);
+        }
+    }
+
+    // Requester side: reassemble the result and surface it through the
+    // runtime's normal response queue
+    void processOffloadResponse(const OffloadResponsePacket& pkt) {
+        OutboundJob* job = nullptr;
+        for (int i = 0; i < MAX_OFFLOAD_JOBS; i++) {
+            if (outbound[i].active && outbound[i].job_id == pkt.job_id) {
+                job = &outbound[i];
+                break;
+            }
+        }
+        if (job == nullptr || runtime == nullptr) return;
+
+        if (!pkt.success || pkt.total_len > OFFLOAD_MAX_OUTPUT) {
+            ModelResponse response = {
+                .success = false,
+                .message = "Remote inference failed",
+                .outputData = nullptr,
+                .outputLength = 0,
+                .requestId = job->request_id,
+                .state = ModelState::ERROR
+            };
+            runtime->injectResponse(response);
+            job->active = false;
+            return;
+        }
+
+        if (pkt.offset + pkt.chunk_len > pkt.total_len) return;
+        memcpy(job->response + pkt.offset, pkt.payload, pkt.chunk_len);
+        job->received += pkt.chunk_len;
+        job->total = pkt.total_len;
+        if (job->received < job->total) return;
+
+        uint8_t* buffer = BufferPool::getInstance().alloc(job->total);
+        if (buffer != nullptr) {
+            memcpy(buffer, job->response, job->total);
+        }
+        ModelResponse response = {
+            .success = (buffer != nullptr),
+            .message = (buffer != nullptr) ? "Remote inference successful"
+                                           : "Buffer pool exhausted",
+            .outputData = buffer,
+            .outputLength = (buffer != nullptr) ? job->total : 0,
+            .requestId = job->request_id,
+            .state = ModelState::READY
+        };
+        runtime->injectResponse(response);
+        job->active = false;
+    }
+
+    // A lost OFFLOAD_RESP must not leak a job slot forever: past the
+    // deadline the requester gets the same error it would for a remote
+    // failure, and the slot goes back into rotation.
+    void sweepOffloadJobs() {
+        if (runtime == nullptr) return;
+        int64_t now = esp_timer_get_time();
+        for (int i = 0; i < MAX_OFFLOAD_JOBS; i++) {
+            if (!outbound[i].active || now < outbound[i].deadline_us) continue;
+            ModelResponse response = {
+                .success = false,
+                .message = "Remote inference timed out",
+                .outputData = nullptr,
+                .outputLength = 0,
+                .requestId = outbound[i].request_id,
+                .state = ModelState::ERROR
+            };
+            runtime->injectResponse(response);
+            outbound[i].active = false;
+        }
+    }
+
+    static void beaconTaskWrapper(void* params) {
+        ((SwarmIntelligenceNode*)params)->beaconTask();
+    }
+
+    void beaconTask() {
+        while (true) {
+            // Wake on notify; the timeout sweeps up anything missed
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+            while (rx_tail != rx_head) {
+                RxFrame* frame = &rx_ring[rx_tail & (RX_RING_SIZE - 1)];
+                processPacket(frame->data, frame->len);
+                // After processPacket so a first beacon's entry exists
+                updateRssi(frame->src_mac, frame->rssi);
+                __sync_synchronize(); // Finish reading before freeing the slot
+                rx_tail = rx_tail + 1;
+            }
+            while (tx_tail != tx_head) {
+                TxEvent* event = &tx_ring[tx_tail & (TX_RING_SIZE - 1)];
+                updateDelivery(event->mac, event->ok != 0);
+                __sync_synchronize();
+                tx_tail = tx_tail + 1;
+            }
+            // Table maintenance lives here so every peers[] mutation
+            // stays on this one task
+            sweepTentativePeers();
+            maybeCheckpointPeers();
+            sweepOffloadJobs();
+            bulk.poll();
+        }
+    }
+
+    // Drop restored entries the swarm never confirmed: past the deadline,
+    // anything still tentative is a ghost from before the reboot
+    void sweepTentativePeers() {
+        if (tentative_sweep_done) return;
+        if (esp_timer_get_time() < tentative_deadline_us) return;
+        int dropped = 0;
+        peers.forEach([&](SwarmPeer& peer) {
+            if (peer.tentative) {
+                peer.is_active = false;
+                peer.tentative = false;
+                dropped++;
+            }
+        });
+        tentative_sweep_done = true;
+        if (dropped > 0) {
+            ESP_LOGI(TAG, "Dropped %d unconfirmed restored peers", dropped);
+        }
+    }
+
+    // Serialize the confirmed active peers into one NVS blob. Gated on
+    // actual churn and rate-limited: NVS pages wear, and a stable swarm
+    // would otherwise rewrite an identical snapshot forever.
+    void maybeCheckpointPeers() {
+        if (!peers_dirty) return;
+        int64_t now = esp_timer_get_time();
+        if (now - last_snapshot_us < PEER_SNAPSHOT_MIN_MS * 1000LL) return;
+
+        // Header: version byte plus a 16-bit little-endian count -- a
+        // single count byte wraps at exactly the 256-peer gateway build
+        static uint8_t blob[3 + PEER_TABLE_CAPACITY * sizeof(PeerSnapshotRecord)];
+        blob[0] = PEER_SNAPSHOT_VERSION;
+        uint16_t n = 0;
+        peers.forEach([&](SwarmPeer& peer) {
+            if (!peer.is_active || peer.tentative) return;
+            PeerSnapshotRecord record;
+            memcpy(record.mac_address, peer.mac_address, 6);
+            memcpy(record.capabilities, peer.capabilities,
+                   sizeof(record.capabilities));
+            record.capability_crc = peer.capability_crc;
+            record.rssi_ewma = peer.rssi_ewma;
+            memcpy(&blob[3 + n * sizeof(record)], &record, sizeof(record));
+            n++;
+        });
+        blob[1] = (uint8_t)(n & 0xFF);
+        blob[2] = (uint8_t)(n >> 8);
+
+        nvs_handle_t nvs;
+        if (nvs_open(PEER_SNAPSHOT_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+            return;
+        }
+        size_t len = 3 + (size_t)n * sizeof(PeerSnapshotRecord);
+        if (nvs_set_blob(nvs, PEER_SNAPSHOT_KEY, blob, len) == ESP_OK) {
+            nvs_commit(nvs);
+            peers_dirty = false;
+            last_snapshot_us = now;
+            ESP_LOGI(TAG, "Peer table checkpointed (%u peers, %u bytes)",
+                     (unsigned)n, (unsigned)len);
+        }
+        nvs_close(nvs);
+    }
+
+    // Reload the last checkpoint. Runs before the beacon task starts, so
+    // the table is still single-owner. Restored entries are marked
+    // tentative and their delivery quality discounted; the top-k lists
+    // are seeded from the stored capabilities so routing and offload
+    // decisions work from the first second after boot.
+    void restorePeerTable() {
+        tentative_sweep_done = true;
+        nvs_handle_t nvs;
+        if (nvs_open(PEER_SNAPSHOT_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+            return;
+        }
+        static uint8_t blob[3 + PEER_TABLE_CAPACITY * sizeof(PeerSnapshotRecord)];
+        size_t len = sizeof(blob);
+        esp_err_t err = nvs_get_blob(nvs, PEER_SNAPSHOT_KEY, blob, &len);
+        nvs_close(nvs);
+        if (err != ESP_OK || len < 3 || blob[0] != PEER_SNAPSHOT_VERSION) {
+            return; // Unknown version (v1 included): rediscover from scratch
+        }
+        size_t n = (size_t)blob[1] | ((size_t)blob[2] << 8);
+        if (len < 3 + n * sizeof(PeerSnapshotRecord)) return;
+
+        for (size_t i = 0; i < n; i++) {
+            PeerSnapshotRecord record;
+            memcpy(&record, &blob[3 + i * sizeof(record)], sizeof(record));
+            SwarmPeer* peer = peers.upsert(record.mac_address);
+            if (peer == nullptr) continue;
+            memcpy(peer->capabilities, record.capabilities,
+                   sizeof(peer->capabilities));
+            peer->capability_crc = record.capability_crc;
+            peer->rssi = record.rssi_ewma;
+            peer->rssi_ewma = record.rssi_ewma;
+            peer->delivery_q8 = 192; // Discounted until re-proven on air
+            peer->is_active = true;
+            peer->tentative = true;
+            updateTopK(record.mac_address, record.capabilities);
+        }
+
+        if (n > 0) {
+            tentative_sweep_done = false;
+            tentative_deadline_us = esp_timer_get_time() +
+                                    PEER_TENTATIVE_WINDOW_MS * 1000LL;
+            ESP_LOGI(TAG, "Restored %u peers from NVS (tentative)", (unsigned)n);
+        }
+    }
+
+    // EWMA with alpha 1/8: settles in ~10 beacons, shrugs off one-frame
+    // fades. The first frame seeds the average directly.
+    void updateRssi(const uint8_t* mac, int8_t rssi) {
+        SwarmPeer* peer = peers.find(mac);
+        if (peer == nullptr) return;
+        peer->rssi = rssi;
+        if (peer->rssi_ewma == 0) {
+            peer->rssi_ewma = rssi;
+        } else {
+            peer->rssi_ewma += ((int)rssi - (int)peer->rssi_ewma) / 8;
+        }
+    }
+
+    // Per-peer unicast delivery quality, Q8 fixed point. Failures are
+    // penalized harder than successes reward: a link has to earn trust
+    // back slowly after dropping frames.
+    void updateDelivery(const uint8_t* mac, bool ok) {
+        SwarmPeer* peer = peers.find(mac);
+        if (peer == nullptr) return;
+        if (ok) {
+            peer->delivery_q8 += (255 - peer->delivery_q8) / 8;
+        } else {
+            peer->delivery_q8 -= peer->delivery_q8 / 4;
+        }
+    }
+
     bool initializeTFLiteModel() {
         // Load pre-trained model
         static const tflite::Model* model = nullptr;
@@ -55,66 +717,249 @@ private:
     }
 
     void sendBeacon() {
-        BeaconPacket beacon;
-        memcpy(beacon.sender_id, node_id, NODE_ID_LENGTH);
-
         // Compute node capabilities using AI model
-        float* input = interpreter->input(0)->data.f;
+        int8_t* input = interpreter->input(0)->data.int8;
         // Prepare input data for model
         if (interpreter->Invoke() != kTfLiteOk) {
             ESP_LOGE(TAG, "TensorFlow Lite Micro inference failed");
             return;
         }
-        float* output = interpreter->output(0)->data.f;
-        memcpy(beacon.capabilities, output, sizeof(beacon.capabilities));
-        beacon.timestamp = esp_timer_get_time();
+        // The model is int8-quantized: take the output tensor as-is, no
+        // dequantize/requantize round trip
+        int8_t* output = interpreter->output(0)->data.int8;
 
-        // Broadcast beacon using ESP-NOW
-        esp_now_send(NULL, (uint8_t*)&beacon, sizeof(BeaconPacket));
-        ESP_LOGI(TAG, "Beacon sent successfully");
+        // Broadcast the full vector only when it has drifted past the
+        // threshold (or a peer asked for a sync); heartbeats otherwise
+        int max_delta = 0;
+        for (int i = 0; i < AI_MODEL_OUTPUT_SIZE; i++) {
+            int delta = abs((int)output[i] - (int)last_sent_capabilities[i]);
+            if (delta > max_delta) max_delta = delta;
+        }
+
+        tx_sequence++;
+        if (force_full_beacon || max_delta > CAPABILITY_DELTA_THRESHOLD) {
+            BeaconPacket beacon;
+            beacon.type = BEACON_TYPE_FULL;
+            memcpy(beacon.sender_id, node_id, NODE_ID_LENGTH);
+            beacon.sequence = tx_sequence;
+            memcpy(beacon.capabilities, output, sizeof(beacon.capabilities));
+            beacon.timestamp = esp_timer_get_time();
+
+            memcpy(last_sent_capabilities, output, sizeof(last_sent_capabilities));
+            last_sent_crc = capability_crc16(last_sent_capabilities);
+            force_full_beacon = false;
+
+            esp_now_send(NULL, (uint8_t*)&beacon, sizeof(BeaconPacket));
+            ESP_LOGI(TAG, "Full beacon sent (seq %u)", tx_sequence);
+        } else {
+            HeartbeatPacket heartbeat;
+            heartbeat.type = BEACON_TYPE_HEARTBEAT;
+            memcpy(heartbeat.sender_id, node_id, NODE_ID_LENGTH);
+            heartbeat.sequence = tx_sequence;
+            heartbeat.capability_crc = last_sent_crc;
+            heartbeat.timestamp = esp_timer_get_time();
+
+            esp_now_send(NULL, (uint8_t*)&heartbeat, sizeof(HeartbeatPacket));
+            ESP_LOGD(TAG, "Heartbeat sent (seq %u)", tx_sequence);
+        }
     }
 
     void processBeacon(const BeaconPacket& beacon) {
-        // Update peer database
-        bool found = false;
-        for (int i = 0; i < MAX_PEERS; i++) {
-            if (memcmp(peers[i].mac_address, beacon.sender_id, NODE_ID_LENGTH) == 0) {
-                found = true;
-                peers[i].last_seen = beacon.timestamp;
-                memcpy(peers[i].capabilities, beacon.capabilities, sizeof(beacon.capabilities));
-                peers[i].is_active = true;
-                break;
-            }
+        // Update peer database: one O(1) hash lookup replaces the old
+        // two-pass linear scan; the table evicts its LRU entry when full
+        bool inserted = false;
+        SwarmPeer* peer = peers.upsert(beacon.sender_id, &inserted);
+        if (peer == nullptr) return;
+        if (inserted) {
+            churn_events++; // New neighbor: topology is moving
+            peers_dirty = true;
+            peer->delivery_q8 = 255; // Trusted until a unicast send fails
         }
+        peer->tentative = false; // Heard on air: restored entry confirmed
 
-        if (!found) {
-            for (int i = 0; i < MAX_PEERS; i++) {
-                if (!peers[i].is_active) {
-                    memcpy(peers[i].mac_address, beacon.sender_id, NODE_ID_LENGTH);
-                    peers[i].last_seen = beacon.timestamp;
-                    memcpy(peers[i].capabilities, beacon.capabilities, sizeof(beacon.capabilities));
-                    peers[i].is_active = true;
-                    break;
-                }
-            }
-        }
+        peer->last_seen = beacon.timestamp;
+        memcpy(peer->capabilities, beacon.capabilities, sizeof(beacon.capabilities));
+        peer->last_sequence = beacon.sequence;
+        peer->capability_crc = capability_crc16(beacon.capabilities);
+        peer->is_active = true;
 
-        // Implement peer ranking and capability matching
-        // ...
+        // Peer ranking and capability matching: amortized incremental update
+        updateTopK(beacon.sender_id, beacon.capabilities);
 
-        ESP_LOGI(TAG, "Beacon received from: %02x:%02x:%02x:%02x:%02x:%02x",
+        // Debug level: at default verbosity a beacon storm must cost table
+        // updates, not a UART line per packet
+        ESP_LOGD(TAG, "Beacon received from: %02x:%02x:%02x:%02x:%02x:%02x",
                  beacon.sender_id[0], beacon.sender_id[1], beacon.sender_id[2],
                  beacon.sender_id[3], beacon.sender_id[4], beacon.sender_id[5]);
     }
 
+    void processHeartbeat(const HeartbeatPacket& heartbeat) {
+        SwarmPeer* peer = peers.find(heartbeat.sender_id);
+        if (peer != nullptr && peer->capability_crc == heartbeat.capability_crc) {
+            // Vector unchanged: just refresh liveness
+            peer->last_seen = heartbeat.timestamp;
+            peer->last_sequence = heartbeat.sequence;
+            peer->tentative = false;
+            peers.touch(peer);
+            return;
+        }
+
+        // Unknown peer or CRC mismatch: ask the sender for a full beacon.
+        // Either way our picture of the swarm was stale -- that's churn.
+        churn_events++;
+        requestSync(heartbeat.sender_id);
+    }
+
+    void processSyncRequest(const SyncRequestPacket& sync) {
+        if (memcmp(sync.target_id, node_id, NODE_ID_LENGTH) == 0) {
+            force_full_beacon = true;
+        }
+    }
+
+    void requestSync(const uint8_t* target_id) {
+        SyncRequestPacket sync;
+        sync.type = BEACON_TYPE_SYNC_REQ;
+        memcpy(sync.sender_id, node_id, NODE_ID_LENGTH);
+        memcpy(sync.target_id, target_id, NODE_ID_LENGTH);
+        esp_now_send(NULL, (uint8_t*)&sync, sizeof(SyncRequestPacket));
+    }
+
+    // Dispatch a received frame on its type byte
+    void processPacket(const uint8_t* data, int len) {
+        switch (data[0]) {
+            case BEACON_TYPE_FULL:
+                if (len == sizeof(BeaconPacket)) {
+                    BeaconPacket beacon;
+                    memcpy(&beacon, data, len);
+                    processBeacon(beacon);
+                }
+                break;
+            case BEACON_TYPE_HEARTBEAT:
+                if (len == sizeof(HeartbeatPacket)) {
+                    HeartbeatPacket heartbeat;
+                    memcpy(&heartbeat, data, len);
+                    processHeartbeat(heartbeat);
+                }
+                break;
+            case BEACON_TYPE_SYNC_REQ:
+                if (len == sizeof(SyncRequestPacket)) {
+                    SyncRequestPacket sync;
+                    memcpy(&sync, data, len);
+                    processSyncRequest(sync);
+                }
+                break;
+            case BEACON_TYPE_OFFLOAD_REQ: {
+                // Variable length: header plus chunk_len payload bytes.
+                // Both bounds matter -- the radio hands us up to
+                // RX_FRAME_MAX bytes, which is larger than the packet
+                // struct, and chunk_len is attacker-controlled.
+                const int header = sizeof(OffloadRequestPacket) - OFFLOAD_CHUNK_PAYLOAD;
+                if (len >= header && len <= (int)sizeof(OffloadRequestPacket)) {
+                    OffloadRequestPacket pkt;
+                    memcpy(&pkt, data, len);
+                    if (pkt.chunk_len <= OFFLOAD_CHUNK_PAYLOAD &&
+                        len >= header + pkt.chunk_len) {
+                        processOffloadRequest(pkt);
+                    }
+                }
+                break;
+            }
+            case BEACON_TYPE_OFFLOAD_RESP: {
+                const int header = sizeof(OffloadResponsePacket) - OFFLOAD_CHUNK_PAYLOAD;
+                if (len >= header && len <= (int)sizeof(OffloadResponsePacket)) {
+                    OffloadResponsePacket pkt;
+                    memcpy(&pkt, data, len);
+                    if (pkt.chunk_len <= OFFLOAD_CHUNK_PAYLOAD &&
+                        len >= header + pkt.chunk_len) {
+                        processOffloadResponse(pkt);
+                    }
+                }
+                break;
+            }
+            case BULK_TYPE_DATA: {
+                // Receive side needs somewhere to stream the payload; a
+                // node with no FileManager attached ignores bulk data
+                if (fileManager == nullptr) break;
+                const int header = sizeof(BulkDataPacket) - BULK_CHUNK_PAYLOAD;
+                if (len >= header && len <= (int)sizeof(BulkDataPacket)) {
+                    BulkDataPacket pkt;
+                    memcpy(&pkt, data, len);
+                    if (pkt.chunk_len <= BULK_CHUNK_PAYLOAD &&
+                        len >= header + pkt.chunk_len) {
+                        // Acks go back unicast, so register the sender
+                        ensurePeerAdded(pkt.sender_id);
+                        bulk.onDataPacket(pkt);
+                    }
+                }
+                break;
+            }
+            case BULK_TYPE_ACK:
+                if (fileManager != nullptr && len == sizeof(BulkAckPacket)) {
+                    BulkAckPacket pkt;
+                    memcpy(&pkt, data, len);
+                    bulk.onAckPacket(pkt);
+                }
+                break;
+        }
+    }
+
     void initESPNOW() {
+        s_instance = this;
+        rx_head = rx_tail = 0;
+        rx_dropped = 0;
+        tx_head = tx_tail = 0;
+
+        // Beacon processing runs on the radio core, below the WiFi task
+        xTaskCreatePinnedToCore(beaconTaskWrapper, "BeaconTask", 4096,
+                                this, 4, &beacon_task_handle, 0);
+
         esp_now_init();
-        esp_now_register_recv_cb([](const uint8_t *mac_addr, const uint8_t *data, int len) {
-            if (len == sizeof(BeaconPacket)) {
-                BeaconPacket beacon;
-                memcpy(&beacon, data, len);
-                processBeacon(beacon);
+        esp_now_register_recv_cb([](const esp_now_recv_info_t *info, const uint8_t *data, int len) {
+            SwarmIntelligenceNode* self = s_instance;
+            if (self == nullptr || len <= 0 || len > RX_FRAME_MAX) return;
+
+            // Bounded work only: copy into the ring and return to the radio
+            uint32_t head = self->rx_head;
+            if (head - self->rx_tail >= RX_RING_SIZE) {
+                self->rx_dropped++;
+                return;
             }
+            RxFrame* frame = &self->rx_ring[head & (RX_RING_SIZE - 1)];
+            frame->len = (uint8_t)len;
+            memcpy(frame->src_mac, info->src_addr, 6);
+            frame->rssi = (info->rx_ctrl != nullptr)
+                              ? (int8_t)info->rx_ctrl->rssi : 0;
+            memcpy(frame->data, data, len);
+            __sync_synchronize(); // Publish the frame before the head bump
+            self->rx_head = head + 1;
+
+            xTaskNotifyGive(self->beacon_task_handle);
+        });
+
+        // Send outcomes feed the adaptive beacon interval (aggregate
+        // counters) and per-peer delivery quality (unicast events, queued
+        // to the beacon task -- the peer table is only touched there)
+        esp_now_register_send_cb([](const uint8_t* mac_addr,
+                                    esp_now_send_status_t status) {
+            SwarmIntelligenceNode* self = s_instance;
+            if (self == nullptr) return;
+            self->send_attempts++;
+            if (status != ESP_NOW_SEND_SUCCESS) self->send_failures++;
+
+            // Broadcast sends carry no ack, so only unicast outcomes
+            // say anything about a specific link
+            static const uint8_t bcast[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+            if (mac_addr == nullptr || memcmp(mac_addr, bcast, 6) == 0) return;
+
+            uint32_t head = self->tx_head;
+            if (head - self->tx_tail >= TX_RING_SIZE) return; // Drop, not block
+            TxEvent* event = &self->tx_ring[head & (TX_RING_SIZE - 1)];
+            memcpy(event->mac, mac_addr, 6);
+            event->ok = (status == ESP_NOW_SEND_SUCCESS) ? 1 : 0;
+            __sync_synchronize();
+            self->tx_head = head + 1;
+
+            xTaskNotifyGive(self->beacon_task_handle);
         });
     }
 
@@ -123,6 +968,32 @@ public:
         // Generate unique node ID
         esp_read_mac(node_id, ESP_MAC_WIFI_STA);
 
+        memset(top_peers, 0, sizeof(top_peers));
+        memset(last_sent_capabilities, 0, sizeof(last_sent_capabilities));
+        tx_sequence = 0;
+        last_sent_crc = capability_crc16(last_sent_capabilities);
+        force_full_beacon = true; // First beacon is always a full one
+
+        beacon_interval_ms = BEACON_INTERVAL_MS;
+        churn_events = 0;
+        send_attempts = 0;
+        send_failures = 0;
+
+        peers_dirty = false;
+        last_snapshot_us = 0;
+        tentative_deadline_us = 0;
+
+        // Rejoin the swarm we knew before the reboot; must happen before
+        // initESPNOW() hands the table to the beacon task
+        restorePeerTable();
+
+        runtime = nullptr;
+        next_job_id = 1;
+        memset(outbound, 0, sizeof(outbound));
+        memset(inbound, 0, sizeof(inbound));
+
+        fileManager = nullptr;
+
         if (!initializeTFLiteModel()) {
             ESP_LOGE(TAG, "Failed to initialize TensorFlow Lite model");
             return;
@@ -131,25 +1002,351 @@ public:
         initESPNOW();
     }
 
+#ifdef SWARM_BENCH
+    // Fleet-qualification hook: feed a synthetic frame through the same
+    // ring and beacon-task dispatch the radio uses. The peer table is
+    // single-writer (every peers[] mutation stays on the beacon task),
+    // so the bench must enqueue like the radio does, not call
+    // processPacket itself. The qualification rig runs radio-quiet, so
+    // this is the ring's only producer during a storm.
+    void injectFrame(const uint8_t* data, int len) {
+        if (len <= 0 || len > RX_FRAME_MAX) return;
+        uint32_t head = rx_head;
+        while (head - rx_tail >= RX_RING_SIZE) {
+            // Ring full: let the beacon task drain a batch
+            xTaskNotifyGive(beacon_task_handle);
+            vTaskDelay(1);
+        }
+        RxFrame* frame = &rx_ring[head & (RX_RING_SIZE - 1)];
+        frame->len = (uint8_t)len;
+        memcpy(frame->src_mac, data + 1, 6); // sender_id doubles as the MAC
+        frame->rssi = -60;                   // Plausible mid-range link
+        memcpy(frame->data, data, len);
+        __sync_synchronize(); // Publish the frame before the head bump
+        rx_head = head + 1;
+        xTaskNotifyGive(beacon_task_handle);
+    }
+
+    // Block until the beacon task has consumed every injected frame; the
+    // storm is only over when the processing is, not the enqueueing
+    void drainInjectedFrames() {
+        while (rx_tail != rx_head) {
+            xTaskNotifyGive(beacon_task_handle);
+            vTaskDelay(1);
+        }
+    }
+#endif
+
+    // Received bulk payloads stream through FileManager append buffers
+    // straight to SD; attaching it arms the receive side of BulkTransfer
+    void attachFileManager(FileManager* fm) {
+        fileManager = fm;
+        bulk.init(node_id, fm);
+    }
+
+    // Reliable bulk push to one peer (model distribution). Blocks until
+    // the peer has acked every chunk or the retry budget runs out.
+    bool sendBulk(const uint8_t* peer, const uint8_t* data, size_t len,
+                  const char* remoteName) {
+        ensurePeerAdded(peer);
+        return bulk.sendBulk(peer, data, len, remoteName);
+    }
+
+    // Bridge to the local ModelRuntime: when its queue is saturated or a
+    // model is not resident, the runtime hands the request to
+    // offloadInference() and the result comes back through injectResponse()
+    void attachRuntime(ModelRuntime* modelRuntime) {
+        runtime = modelRuntime;
+        runtime->registerOffloadHandler(
+            [](const char* modelId, uint8_t* inputData, size_t inputLength,
+               uint32_t requestId, void* arg) -> bool {
+                return ((SwarmIntelligenceNode*)arg)->offloadInference(
+                    modelId, inputData, inputLength, requestId);
+            },
+            this);
+    }
+
+    // Link cost, lower is better: attenuation in dB above a -30 dBm
+    // reference plus up to 64 penalty points for dropped unicast frames.
+    // A peer at -60 dBm delivering everything costs 30; a peer at -85 dBm
+    // dropping half its frames costs ~87. An unmeasured link (no frame
+    // seen yet) is charged as if marginal so measured links win ties.
+    int getLinkCost(const SwarmPeer& peer) {
+        int rssi = (peer.rssi_ewma != 0) ? peer.rssi_ewma : -90;
+        int attenuation = -30 - rssi;
+        if (attenuation < 0) attenuation = 0;
+        int drop_penalty = (255 - (int)peer.delivery_q8) / 4;
+        return attenuation + drop_penalty;
+    }
+
+    // Best peers for one capability dimension, best first. Returns how
+    // many MACs were written (up to k, capped at MATCH_TOP_K). Candidates
+    // come from the incrementally maintained capability list (evicted
+    // peers are skipped); among them the ranking blends capability score
+    // with measured link cost, so a capable peer on a marginal link loses
+    // to a slightly less capable one we can actually reach. k <= 4, so
+    // the selection sort is a handful of compares.
+    int findBestPeers(int capability, int k, uint8_t out_macs[][6]) {
+        if (capability < 0 || capability >= AI_MODEL_OUTPUT_SIZE) return 0;
+        if (k > MATCH_TOP_K) k = MATCH_TOP_K;
+
+        SwarmPeer* cand[MATCH_TOP_K];
+        int rank[MATCH_TOP_K];
+        int n = 0;
+        TopKEntry* list = top_peers[capability];
+        for (int i = 0; i < MATCH_TOP_K; i++) {
+            if (!list[i].valid) break;
+            SwarmPeer* peer = peers.find(list[i].mac_address);
+            if (peer == nullptr || !peer->is_active) continue;
+            cand[n] = peer;
+            // Score spans ~[-128,127], cost ~[0,130]: x4 keeps capability
+            // dominant until the link is genuinely bad
+            rank[n] = (int)list[i].score * 4 - getLinkCost(*peer);
+            n++;
+        }
+
+        for (int i = 0; i < n; i++) {
+            int best = i;
+            for (int j = i + 1; j < n; j++) {
+                if (rank[j] > rank[best]) best = j;
+            }
+            SwarmPeer* p = cand[best]; cand[best] = cand[i]; cand[i] = p;
+            int r = rank[best]; rank[best] = rank[i]; rank[i] = r;
+        }
+
+        int written = (n < k) ? n : k;
+        for (int i = 0; i < written; i++) {
+            memcpy(out_macs[i], cand[i]->mac_address, 6);
+        }
+        return written;
+    }
+
+    // Best whole-vector match for a required capability profile; used by
+    // the task-offload path. Full scan with the int8 dot-product kernel.
+    SwarmPeer* findBestMatch(const int8_t* required) {
+        SwarmPeer* best = nullptr;
+        int32_t best_score = INT32_MIN;
+        peers.forEach([&](SwarmPeer& peer) {
+            if (!peer.is_active) return;
+            int32_t score = capability_similarity(required, peer.capabilities);
+            if (score > best_score) {
+                best_score = score;
+                best = &peer;
+            }
+        });
+        return best;
+    }
+
     void run() {
         while (true) {
             sendBeacon();
-            vTaskDelay(pdMS_TO_TICKS(BEACON_INTERVAL_MS));
+            vTaskDelay(pdMS_TO_TICKS(beacon_interval_ms));
+            adaptBeaconInterval();
+        }
+    }
+
+private:
+    // Pick the next beacon interval from what the last one observed.
+    // Churn or failing sends snap back to the minimum; a quiet interval
+    // doubles the backoff toward a ceiling set by swarm density. A node
+    // with few neighbors keeps a tighter ceiling -- it is still
+    // discovering -- while a dense static cluster settles at the maximum
+    // and stops burning airtime on beacons that convey nothing new.
+    void adaptBeaconInterval() {
+        uint32_t churn = churn_events;
+        uint32_t attempts = send_attempts;
+        uint32_t failures = send_failures;
+        churn_events = 0;
+        send_attempts = 0;
+        send_failures = 0;
+
+        bool sends_degraded =
+            attempts > 0 && failures * 100 > attempts * BEACON_FAIL_RATE_PCT;
+
+        uint32_t next;
+        if (churn > 0 || sends_degraded) {
+            next = BEACON_INTERVAL_MIN_MS;
+        } else {
+            uint32_t ceiling = (peers.size() >= BEACON_DENSE_PEER_COUNT)
+                                   ? BEACON_INTERVAL_MAX_MS
+                                   : BEACON_SPARSE_MAX_MS;
+            next = beacon_interval_ms * 2;
+            if (next > ceiling) next = ceiling;
+        }
+
+        if (next != beacon_interval_ms) {
+            ESP_LOGI(TAG, "Beacon interval %u -> %u ms (peers %u, churn %u, "
+                          "send fail %u/%u)",
+                     (unsigned)beacon_interval_ms, (unsigned)next,
+                     (unsigned)peers.size(), (unsigned)churn,
+                     (unsigned)failures, (unsigned)attempts);
+            beacon_interval_ms = next;
         }
     }
 };
 
+SwarmIntelligenceNode* SwarmIntelligenceNode::s_instance = nullptr;
+
+#ifdef SWARM_BENCH
+// ===== Microbenchmark firmware ==========================================
+// Build with -DSWARM_BENCH to get the benchmark image used by the
+// fleet-qualification rig. Output is machine-parsable CSV on the default
+// console, one row per measurement:
+//
+//   BENCH,<suite>,<param>,<iters>,<total_us>,<per_op_us>,<kb_per_s>
+//
+// The run ends with "BENCH,done" so the rig knows the tables are complete.
+
+static void benchReport(const char* suite, const char* param, int iters,
+                        int64_t totalUs, int64_t bytes) {
+    int64_t perOp = (iters > 0) ? totalUs / iters : 0;
+    int64_t kbps = (totalUs > 0) ? (bytes * 1000000LL) / (totalUs * 1024LL) : 0;
+    printf("BENCH,%s,%s,%d,%lld,%lld,%lld\n", suite, param, iters,
+           (long long)totalUs, (long long)perOp, (long long)kbps);
+}
+
+static void benchFileManager(FileManager& fm) {
+    static const size_t sizes[] = { 512, 2048, 8192, 32768 };
+    const char* path = "/sdcard/data/bench.bin";
+    char param[16];
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        size_t size = sizes[s];
+        uint8_t* buf = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_8BIT);
+        if (buf == nullptr) continue;
+        for (size_t j = 0; j < size; j++) buf[j] = (uint8_t)j;
+        snprintf(param, sizeof(param), "%u", (unsigned)size);
+
+        const int iters = 8;
+        FileResponse resp;
+
+        int64_t t0 = esp_timer_get_time();
+        for (int i = 0; i < iters; i++) {
+            fm.requestWrite(path, buf, size, i);
+            fm.getResponse(resp);
+        }
+        benchReport("file_write", param, iters, esp_timer_get_time() - t0,
+                    (int64_t)size * iters);
+
+        // Sizes under READ_CACHE_MAX_FILE hit the read cache after the
+        // first pass; that is the shipping behavior, so it is what gets
+        // measured. 32 KB rows are pure SD throughput.
+        t0 = esp_timer_get_time();
+        for (int i = 0; i < iters; i++) {
+            fm.requestRead(path, i);
+            fm.getResponse(resp);
+            if (resp.data != nullptr) BufferPool::getInstance().release(resp.data);
+        }
+        benchReport("file_read", param, iters, esp_timer_get_time() - t0,
+                    (int64_t)size * iters);
+
+        free(buf);
+    }
+}
+
+static void benchModelRuntime(ModelRuntime& rt) {
+    static const char* modelIds[] = { "anomaly_detector", "capability_matcher" };
+    static uint8_t input[AI_MODEL_INPUT_SIZE] = {};
+
+    for (size_t m = 0; m < sizeof(modelIds) / sizeof(modelIds[0]); m++) {
+        ModelResponse resp;
+
+        int64_t t0 = esp_timer_get_time();
+        rt.requestModelLoad(modelIds[m], 0);
+        rt.getResponse(resp);
+        benchReport("model_load", modelIds[m], 1, esp_timer_get_time() - t0, 0);
+        if (!resp.success) continue;
+
+        int32_t handle = resp.modelHandle;
+        const int iters = 32;
+        t0 = esp_timer_get_time();
+        for (int i = 0; i < iters; i++) {
+            rt.requestInference(handle, input, sizeof(input), (uint32_t)i);
+            rt.getResponse(resp);
+            if (resp.outputData != nullptr) {
+                BufferPool::getInstance().release(resp.outputData);
+            }
+        }
+        benchReport("model_invoke", modelIds[m], iters,
+                    esp_timer_get_time() - t0, 0);
+    }
+}
+
+static void benchBeaconPath(SwarmIntelligenceNode& node) {
+    BeaconPacket beacon;
+    memset(&beacon, 0, sizeof(beacon));
+    beacon.type = BEACON_TYPE_FULL;
+
+    // 256 synthetic senders cycling so the storm exercises table churn,
+    // top-k updates and LRU eviction, not just one peer's entry
+    const int iters = 2048;
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < iters; i++) {
+        beacon.sender_id[5] = (uint8_t)i;
+        beacon.sender_id[4] = (uint8_t)(i >> 8) ^ 0xA5;
+        beacon.sequence = (uint16_t)i;
+        for (int d = 0; d < AI_MODEL_OUTPUT_SIZE; d++) {
+            beacon.capabilities[d] = (int8_t)((i + d * 7) & 0x7F);
+        }
+        node.injectFrame((const uint8_t*)&beacon, sizeof(beacon));
+    }
+    node.drainInjectedFrames();
+    benchReport("beacon_storm", "full", iters, esp_timer_get_time() - t0,
+                (int64_t)iters * sizeof(BeaconPacket));
+}
+
+static void bench_main() {
+    // The storms measure steady-state cost, so wait for every stage
+    // (app_main already launched them) rather than racing the SD mount
+    SystemKernel::getInstance().waitReady(SystemKernel::READY_ALL);
+
+    static FileManager fileManager;
+    static ModelRuntime modelRuntime;
+    static SwarmIntelligenceNode swarmNode;
+
+    // Let the subsystem tasks come up before the storms start
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    benchFileManager(fileManager);
+    benchModelRuntime(modelRuntime);
+    benchBeaconPath(swarmNode);
+
+    printf("BENCH,done\n");
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+}
+#endif // SWARM_BENCH
+
 extern "C" void app_main() {
-    // Initialize NVS
-    nvs_flash_init();
+    // Kernel init stages (NVS, SPIFFS, SD) run as parallel tasks across
+    // both cores; radio bring-up below overlaps the ~900 ms SD mount
+    // instead of queueing behind it
+    SystemKernel& kernel = SystemKernel::getInstance();
+    kernel.init();
 
-    // Configure WiFi
+    // WiFi needs NVS (milliseconds); it does not need storage
+    kernel.waitReady(SystemKernel::READY_NVS);
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     esp_wifi_init(&cfg);
     esp_wifi_set_mode(WIFI_MODE_STA);
     esp_wifi_start();
+    kernel.signalReady(SystemKernel::READY_RADIO);
 
-    // Create Swarm Intelligence Node
+#ifdef SWARM_BENCH
+    bench_main(); // Never returns
+#else
+    // Create Swarm Intelligence Node. The first beacon goes out as soon
+    // as the radio is up -- storage is still mounting in the background
     SwarmIntelligenceNode swarmNode;
+
+    // Arm the bulk-transfer receive side: inbound model files stream
+    // through FileManager append buffers to SD. Until this attach the
+    // beacon task drops bulk frames, so the race with the SD mount is
+    // benign.
+    static FileManager fileManager;
+    swarmNode.attachFileManager(&fileManager);
+
     swarmNode.run();
+#endif
 }